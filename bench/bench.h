@@ -0,0 +1,51 @@
+// bench.h
+//
+// Small helpers shared by the Verilator benchmarks in this directory.
+// Each benchmark collects named numbers (throughput per clock, latency in
+// cycles) and writes them as a flat JSON object to results/<bench>.json,
+// where compare.sh checks them against baseline/<bench>.json.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+class BenchResult {
+public:
+    explicit BenchResult(const char* name) : m_name(name) {}
+
+    // Names ending in "_per_clock" or "_per_second" are throughputs (higher
+    // is better). All other names are latencies or costs (lower is better).
+    void add(const char* key, double value) {
+        m_values.push_back(std::make_pair(std::string(key), value));
+        printf("%-12s %-32s %10.4f\n", m_name.c_str(), key, value);
+    }
+
+    bool write() const {
+        std::string path = "results/" + m_name + ".json";
+        FILE* f = fopen(path.c_str(), "w");
+        if (!f) {
+            printf("Cannot open %s\n", path.c_str());
+            return false;
+        }
+        fprintf(f, "{\n    \"bench\": \"%s\"", m_name.c_str());
+        for (const auto& v : m_values) {
+            fprintf(f, ",\n    \"%s\": %.4f", v.first.c_str(), v.second);
+        }
+        fprintf(f, "\n}\n");
+        fclose(f);
+        return true;
+    }
+
+private:
+    std::string m_name;
+    std::vector<std::pair<std::string, double>> m_values;
+};
+
+#endif // _BENCH_H_
@@ -0,0 +1,135 @@
+// bench_canvas.cpp
+//
+// Measures the canvas (canvas.v): pixels per clock from the frame buffer
+// through the palette, the pixel clocks from a scan position change to the
+// matching output color, and blit port bytes per memory clock while the
+// display is being fetched and while it is replayed from the line buffer.
+// The frame buffer and palette are loaded from the sample image by the
+// modules themselves.
+//
+// The memory clock runs at 4 times the pixel clock. One "pixel tick" below
+// is 4 memory clocks, ending with the pixel clock edge.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#include "Vcanvas.h"
+#include "bench.h"
+#include "testbench.h"
+
+#define PIXELS          1000
+#define LATENCY_LIMIT   32
+#define SETTLE          4
+#define BLIT_BYTES      300
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    Testbench<Vcanvas> tb([](Vcanvas* m) { return &m->i_mem_clk; },
+                          [](Vcanvas* m) { return &m->i_rst; });
+    BenchResult result("canvas");
+
+    // The pixel phase (and so the pixel clock) changes with each memory
+    // clock edge; it is set up just before the edge that sees it.
+    int phase = 0;
+    auto next_phase = [&] {
+        phase = (phase + 1) & 3;
+        tb.m->i_pix_phase = phase;
+        tb.m->i_pix_clk = (phase < 2);
+    };
+    auto mem_tick = [&] {
+        next_phase();
+        tb.tick();
+    };
+    auto pix_tick = [&] {
+        for (int i = 0; i < 4; i++) {
+            mem_tick();
+        }
+    };
+    auto pix_ticks = [&](int count) {
+        for (int i = 0; i < count; i++) {
+            pix_tick();
+        }
+    };
+
+    tb.m->i_blank = 0;
+    tb.m->i_cmd_clk = 0;
+    tb.m->i_cmd_data = 0;
+    tb.m->i_scan_row = 0;
+    tb.m->i_scan_column = 0;
+    tb.m->i_repeat_row = 0;
+    tb.m->i_repeat_column = 0;
+    tb.m->i_blit_stb = 0;
+    tb.m->i_blit_we = 0;
+    tb.reset(0);
+
+    // Find a pixel on the first row whose color differs from pixel 0.
+    auto color_at = [&](int column) {
+        tb.m->i_scan_column = column;
+        pix_ticks(SETTLE);
+        return (int) tb.m->o_color;
+    };
+    int color0 = color_at(0);
+    int column = 1;
+    int color1 = color0;
+    while (column < 320) {
+        color1 = color_at(column);
+        if (color1 != color0) break;
+        column++;
+    }
+    if (color1 == color0) {
+        printf("canvas: first row is a single color\n");
+        return 1;
+    }
+
+    color_at(0);
+    tb.m->i_scan_column = column;
+    int latency = 0;
+    while (tb.m->o_color != color1 && latency < LATENCY_LIMIT) {
+        pix_tick();
+        latency++;
+    }
+    result.add("scan_latency_cycles", latency);
+
+    int changes = 0;
+    int last_color = tb.m->o_color;
+    for (int i = 0; i < PIXELS; i++) {
+        tb.m->i_scan_column = (i & 1) ? 0 : column;
+        pix_tick();
+        if (tb.m->o_color != last_color) {
+            changes++;
+            last_color = tb.m->o_color;
+        }
+    }
+    result.add("pixels_per_clock", (double) changes / PIXELS);
+
+    // Write bytes through the blit port as fast as it grants them, while
+    // the display keeps fetching. Writes go to a row off the visible area.
+    auto blit = [&] {
+        uint64_t start = tb.cycles();
+        int written = 0;
+        tb.m->i_blit_stb = 1;
+        tb.m->i_blit_we = 1;
+        tb.m->i_blit_row = 255;
+        while (written < BLIT_BYTES) {
+            next_phase();
+            tb.m->i_blit_col = written % 336;
+            tb.m->i_blit_data = written & 0xFF;
+            tb.m->eval();
+            if (tb.m->o_blit_grant) {
+                written++;
+            }
+            tb.tick();
+        }
+        tb.m->i_blit_stb = 0;
+        return (double) written / (tb.cycles() - start);
+    };
+    result.add("blit_bytes_per_clock", blit());
+
+    // On a repeated line of a scan-doubled mode, the display is replayed
+    // from the line buffer, and the blit port gets every slot.
+    tb.m->i_repeat_row = 1;
+    result.add("blit_bytes_per_clock_doubled", blit());
+    tb.m->i_repeat_row = 0;
+
+    return result.write() ? 0 : 1;
+}
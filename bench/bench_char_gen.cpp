@@ -0,0 +1,51 @@
+// bench_char_gen.cpp
+//
+// Measures the glyph generator (char_gen8x8.v) in isolation: the cycles
+// from a character position change to the matching alpha code, and alpha
+// codes per clock. One glyph row is preloaded with a known pattern.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#include "Vchar_gen8x8.h"
+#include "Vchar_gen8x8___024root.h"
+#include "bench.h"
+#include "testbench.h"
+
+#define CHAR            0x41
+#define PIXELS          1000
+#define LATENCY_LIMIT   32
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    Testbench<Vchar_gen8x8> tb([](Vchar_gen8x8* m) { return &m->i_clk; });
+    BenchResult result("char_gen");
+
+    // Row 0 of the glyph alternates between 0% and 100% opaque, so columns
+    // 0 and 1 give different alpha codes.
+    const uint8_t row[8] = { 0x0, 0xF, 0x0, 0xF, 0x0, 0xF, 0x0, 0xF };
+    preload(tb.m->rootp->char_gen8x8__DOT__glyphs, row, 8, CHAR * 64);
+
+    tb.m->i_char = CHAR;
+    tb.m->i_row = 0;
+    tb.m->i_column = 0;
+    tb.ticks(4);
+    tb.m->i_column = 1;
+    int latency = tb.wait_until([&] { return tb.m->o_alpha == 0xF; },
+                                LATENCY_LIMIT);
+    result.add("alpha_latency_cycles", latency);
+
+    int changes = 0;
+    int last_alpha = tb.m->o_alpha;
+    for (int i = 0; i < PIXELS; i++) {
+        tb.m->i_column = (i & 1) ? 1 : 0;
+        tb.tick();
+        if (tb.m->o_alpha != last_alpha) {
+            changes++;
+            last_alpha = tb.m->o_alpha;
+        }
+    }
+    result.add("pixels_per_clock", (double) changes / PIXELS);
+
+    return result.write() ? 0 : 1;
+}
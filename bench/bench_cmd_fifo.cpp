@@ -0,0 +1,85 @@
+// bench_cmd_fifo.cpp
+//
+// Measures the dual-clock command FIFO (cmd_fifo.v) between the 100 MHz
+// engine domain (write side) and the 25 MHz pixel domain (read side):
+// words per clock on each side, and the read clocks from a write until the
+// word is visible on the read side.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#include "Vcmd_fifo.h"
+#include "bench.h"
+#include "testbench.h"
+
+#define DEPTH           16
+#define LATENCY_LIMIT   32
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    Testbench<Vcmd_fifo> tb([](Vcmd_fifo* m) { return &m->i_wr_clk; },
+                            [](Vcmd_fifo* m) { return &m->i_rst; });
+    BenchResult result("cmd_fifo");
+
+    // The read clock rises on every fourth write clock edge.
+    int phase = 0;
+    auto wr_tick = [&] {
+        phase = (phase + 1) & 3;
+        tb.m->i_rd_clk = (phase < 2);
+        tb.tick();
+    };
+    auto rd_tick = [&] {
+        do { wr_tick(); } while (phase != 0);
+    };
+
+    tb.m->i_wr_en = 0;
+    tb.m->i_rd_en = 0;
+    tb.m->i_wr_data = 0;
+    tb.reset(0);
+    rd_tick();
+
+    // Write until full, with the read side idle.
+    int written = 0;
+    uint64_t start = tb.cycles();
+    tb.m->i_wr_en = 1;
+    while (!tb.m->o_full && written < 2 * DEPTH) {
+        tb.m->i_wr_data = 0x10000000 + written;
+        wr_tick();
+        written++;
+    }
+    tb.m->i_wr_en = 0;
+    result.add("write_words_per_clock", (double) written / (tb.cycles() - start));
+
+    // Read until empty, one word per read clock.
+    for (int i = 0; i < 4; i++) rd_tick();
+    int read = 0;
+    int rd_clocks = 0;
+    tb.m->i_rd_en = 1;
+    while (!tb.m->o_empty && rd_clocks < 4 * DEPTH) {
+        read++;
+        rd_tick();
+        rd_clocks++;
+    }
+    tb.m->i_rd_en = 0;
+    result.add("read_words_per_clock", (double) read / rd_clocks);
+    if (read != written) {
+        printf("cmd_fifo: wrote %d words, read %d\n", written, read);
+        return 1;
+    }
+
+    // Write one word just after a read clock edge, and count read clocks
+    // until it can be seen.
+    for (int i = 0; i < 4; i++) rd_tick();
+    tb.m->i_wr_en = 1;
+    tb.m->i_wr_data = 0x12345678;
+    wr_tick();
+    tb.m->i_wr_en = 0;
+    int latency = 0;
+    while (tb.m->o_empty && latency < LATENCY_LIMIT) {
+        rd_tick();
+        latency++;
+    }
+    result.add("cross_latency_rd_clocks", latency);
+
+    return result.write() ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+// bench_cmd_processor.cpp
+//
+// Measures the command processor (cmd_processor.v): commands per clock
+// fetched from the command ring, commands per clock run from a command
+// list called from the ring, the clocks from the vertical blank (or the
+// command FIFO draining) until the command held by WAIT_VBLANK (or FENCE)
+// is passed on, and direct host commands per clock. The
+// PSRAM behind the arbiter is modeled here, answering each read after a
+// fixed number of clocks (the read latency measured by bench_psram), and
+// the commands leaving the processor are checked against the ring and the
+// list.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#include "Vcmd_processor.h"
+#include "bench.h"
+#include "testbench.h"
+
+#define READ_LATENCY    17
+#define RING_BASE       0x1000
+#define RING_SIZE       8
+#define RING_COMMANDS   64
+#define LIST_ADDR       (RING_BASE + 1024)
+#define LIST_COMMANDS   16
+#define PSRAM_WORDS     4096
+#define HOST_COMMANDS   64
+#define FETCH_LIMIT     (RING_COMMANDS * 4 * READ_LATENCY)
+
+#define REG_RING_BASE   0
+#define REG_RING_SIZE   1
+#define REG_RING_HEAD   2
+
+#define CMD_CALL        0xF1000000
+#define CMD_RETURN      0xF2000000
+#define CMD_WAIT_VBLANK 0xF3000000
+#define CMD_FENCE       0xF5000000
+#define FENCE_ID        0x000123
+#define VBLANK_LINE     480
+#define WAIT_LIMIT      100
+
+typedef Testbench<Vcmd_processor> ProcessorBench;
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    ProcessorBench tb([](Vcmd_processor* m) { return &m->i_clk; },
+                      [](Vcmd_processor* m) { return &m->i_rst; });
+    BenchResult result("cmd_processor");
+
+    // PSRAM, as 16-bit words from RING_BASE, upper half of each command
+    // first. The ring holds display commands, then one CALL of the list.
+    std::vector<uint16_t> psram(PSRAM_WORDS);
+    auto store = [&](int addr, uint32_t c) {
+        psram[addr - RING_BASE] = c >> 16;
+        psram[addr - RING_BASE + 1] = c & 0xFFFF;
+    };
+    std::vector<uint32_t> commands;
+    for (int i = 0; i < RING_COMMANDS; i++) {
+        uint32_t c = 0x10000000 + (uint32_t) i * 0x00010203;
+        commands.push_back(c);
+        store(RING_BASE + 2 * i, c);
+    }
+    store(RING_BASE + 2 * RING_COMMANDS, CMD_CALL | LIST_ADDR);
+    std::vector<uint32_t> list;
+    for (int i = 0; i < LIST_COMMANDS; i++) {
+        uint32_t c = 0x30000000 + i;
+        list.push_back(c);
+        store(LIST_ADDR + 2 * i, c);
+    }
+    store(LIST_ADDR + 2 * LIST_COMMANDS, CMD_RETURN);
+
+    // After the CALL: a command held by WAIT_VBLANK, then one held by FENCE.
+    int wait_index = RING_COMMANDS + 1;
+    store(RING_BASE + 2 * wait_index, CMD_WAIT_VBLANK);
+    store(RING_BASE + 2 * wait_index + 2, 0x40000001);
+    store(RING_BASE + 2 * wait_index + 4, CMD_FENCE | FENCE_ID);
+    store(RING_BASE + 2 * wait_index + 6, 0x40000002);
+
+    // One clock, with the modeled PSRAM answering the request (if any), and
+    // any command leaving the processor collected.
+    std::vector<uint32_t> received;
+    int wait = 0;
+    auto tick = [&] {
+        tb.m->i_mem_ack = 0;
+        if (tb.m->o_mem_req) {
+            if (++wait >= READ_LATENCY) {
+                wait = 0;
+                tb.m->i_mem_ack = 1;
+                tb.m->i_mem_data = psram[(tb.m->o_mem_addr - RING_BASE) % PSRAM_WORDS];
+            }
+        } else {
+            wait = 0;
+        }
+        tb.m->eval();
+        if (tb.m->o_cmd_valid && !tb.m->i_cmd_full) {
+            received.push_back(tb.m->o_cmd_data);
+        }
+        tb.tick();
+    };
+    auto write_reg = [&](int addr, uint32_t data) {
+        tb.m->i_reg_we = 1;
+        tb.m->i_reg_addr = addr;
+        tb.m->i_reg_data = data;
+        tick();
+        tb.m->i_reg_we = 0;
+    };
+
+    tb.m->i_reg_we = 0;
+    tb.m->i_host_valid = 0;
+    tb.m->i_mem_ack = 0;
+    tb.m->i_cmd_full = 0;
+    tb.m->i_cmd_empty = 1;
+    tb.m->i_display_idle = 1;
+    tb.m->i_scan_line = 100;
+    tb.reset(0);
+    tick();
+
+    // Queue the whole ring at once, and let the processor drain it.
+    write_reg(REG_RING_BASE, RING_BASE);
+    write_reg(REG_RING_SIZE, RING_SIZE);
+    write_reg(REG_RING_HEAD, RING_COMMANDS);
+    uint64_t start = tb.cycles();
+    int limit = FETCH_LIMIT;
+    while (tb.m->o_ring_tail != RING_COMMANDS && limit-- > 0) {
+        tick();
+    }
+    if (received != commands) {
+        printf("cmd_processor: ring commands were not passed on in order\n");
+        return 1;
+    }
+    result.add("ring_commands_per_clock",
+               (double) RING_COMMANDS / (tb.cycles() - start));
+
+    // Call the list with one ring command, and count from the CALL being
+    // queued until the last list command is passed on.
+    received.clear();
+    start = tb.cycles();
+    write_reg(REG_RING_HEAD, RING_COMMANDS + 1);
+    limit = FETCH_LIMIT;
+    while (received.size() < LIST_COMMANDS && limit-- > 0) {
+        tick();
+    }
+    if (received != list) {
+        printf("cmd_processor: list commands were not passed on in order\n");
+        return 1;
+    }
+    result.add("list_commands_per_clock",
+               (double) LIST_COMMANDS / (tb.cycles() - start));
+    for (int i = 0; i < 4 * READ_LATENCY; i++) {
+        tick(); // the RETURN
+    }
+
+    // Queue the WAIT_VBLANK and its command, give the processor time to
+    // fetch both, then start the vertical blank.
+    received.clear();
+    write_reg(REG_RING_HEAD, wait_index + 2);
+    for (int i = 0; i < 8 * READ_LATENCY; i++) {
+        tick();
+    }
+    if (!received.empty()) {
+        printf("cmd_processor: WAIT_VBLANK did not wait\n");
+        return 1;
+    }
+    tb.m->i_scan_line = VBLANK_LINE;
+    result.add("vblank_latency_cycles",
+               tb.wait_until([&] { return tb.m->o_cmd_valid != 0; }, WAIT_LIMIT));
+    tick();
+
+    // The same for FENCE, with the command FIFO not yet drained.
+    tb.m->i_cmd_empty = 0;
+    write_reg(REG_RING_HEAD, wait_index + 4);
+    for (int i = 0; i < 8 * READ_LATENCY; i++) {
+        tick();
+    }
+    if (received.size() != 1 || tb.m->o_last_fence == FENCE_ID) {
+        printf("cmd_processor: FENCE did not wait\n");
+        return 1;
+    }
+    tb.m->i_cmd_empty = 1;
+    result.add("fence_latency_cycles",
+               tb.wait_until([&] { return tb.m->o_cmd_valid != 0; }, WAIT_LIMIT));
+    if (tb.m->o_last_fence != FENCE_ID) {
+        printf("cmd_processor: FENCE was not recorded\n");
+        return 1;
+    }
+    tick();
+
+    // Direct host commands, one offered on every clock.
+    received.clear();
+    start = tb.cycles();
+    tb.m->i_host_valid = 1;
+    for (int i = 0; i < HOST_COMMANDS; i++) {
+        tb.m->i_host_data = 0x20000000 + i;
+        tick();
+    }
+    tb.m->i_host_valid = 0;
+    result.add("host_commands_per_clock",
+               (double) received.size() / (tb.cycles() - start));
+
+    return result.write() ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+// bench_psram.cpp
+//
+// Measures the PSRAM controller (psram.v): cycles from strobe to done for
+// single reads and writes, and words per clock with the strobe held. Also
+// reports which controller states were reached. No PSRAM chip is modeled;
+// read data is not checked.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#include "Vpsram.h"
+#include "bench.h"
+#include "testbench.h"
+
+#define STATE_IDLE      12
+#define STARTUP_LIMIT   50000
+#define DONE_LIMIT      100
+#define BURST_WORDS     100
+
+typedef Testbench<Vpsram> PsramBench;
+
+// Strobes one transaction, and returns the clocks until it is done.
+static int transact(PsramBench& tb, int we) {
+    tb.m->i_we = we;
+    tb.m->i_stb = 1;
+    tb.tick();
+    tb.m->i_stb = 0;
+    int cycles = tb.wait_until([&] { return tb.m->o_done != 0; }, DONE_LIMIT);
+    return cycles < 0 ? -1 : cycles + 1;
+}
+
+// Holds the strobe for a run of transactions, and returns words per clock.
+static double burst(PsramBench& tb, int we) {
+    uint64_t start = tb.cycles();
+    int words = 0;
+    int last_done = tb.m->o_done;
+    tb.m->i_we = we;
+    tb.m->i_stb = 1;
+    while (words < BURST_WORDS) {
+        tb.tick();
+        if (tb.m->o_done && !last_done) {
+            words++;
+        }
+        last_done = tb.m->o_done;
+    }
+    tb.m->i_stb = 0;
+    return (double) words / (tb.cycles() - start);
+}
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    PsramBench tb([](Vpsram* m) { return &m->i_clk; },
+                  [](Vpsram* m) { return &m->i_rst; });
+    BenchResult result("psram");
+    StateCoverage coverage(psram_state_names, PSRAM_STATE_COUNT);
+
+    tb.m->i_stb = 0;
+    tb.m->i_we = 0;
+    tb.m->i_addr = 0x123456;
+    tb.m->i_din = 0xA5C3;
+    tb.reset();
+
+    int startup = tb.wait_until([&] { return tb.m->o_state == STATE_IDLE; },
+                                STARTUP_LIMIT);
+    if (startup < 0) {
+        printf("psram: did not reach IDLE after %d clocks\n", STARTUP_LIMIT);
+        return 1;
+    }
+    result.add("startup_cycles", startup);
+
+    result.add("write_latency_cycles", transact(tb, 1));
+    result.add("read_latency_cycles", transact(tb, 0));
+    result.add("write_words_per_clock", burst(tb, 1));
+    tb.wait_until([&] { return tb.m->o_state == STATE_IDLE; }, DONE_LIMIT);
+    result.add("read_words_per_clock", burst(tb, 0));
+
+    coverage.print(tb.m->states_hit);
+    result.add("states_missed", coverage.missed(tb.m->states_hit));
+
+    return result.write() ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+// bench_readback.cpp
+//
+// Measures the readback module (readback.v): register reads per clock
+// with a new read given on every clock (no waiting for earlier answers),
+// and the clocks from a frame buffer read being taken until its answer.
+// The frame buffer blit port is modeled here, granting every access at
+// once, and the answers' tags and data are checked.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#include "Vreadback.h"
+#include "bench.h"
+#include "testbench.h"
+
+#define SPACE_REGS      0
+#define SPACE_FRAME     2
+#define REG_READS       64
+#define READ_LIMIT      32
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    Testbench<Vreadback> tb([](Vreadback* m) { return &m->i_clk; },
+                            [](Vreadback* m) { return &m->i_rst; });
+    BenchResult result("readback");
+
+    // One clock, with the register file and the blit port modeled. The
+    // blit port answers on the clock after it grants, like canvas.v.
+    int fb_answer = 0;
+    auto tick = [&] {
+        tb.m->eval();
+        tb.m->i_reg_data = 0xA0000000 | tb.m->o_reg_addr;
+        tb.m->i_fb_grant = tb.m->o_fb_stb;
+        tb.m->i_fb_valid = fb_answer;
+        tb.m->i_fb_data = 0x5A;
+        tb.m->eval();
+        fb_answer = tb.m->o_fb_stb;
+        tb.tick();
+    };
+
+    tb.m->i_req_valid = 0;
+    tb.m->i_rsp_ready = 1;
+    tb.m->i_disp_empty = 1;
+    tb.m->i_fb_grant = 0;
+    tb.m->i_fb_valid = 0;
+    tb.m->i_edge_data = 0;
+    tb.m->i_glyph_data = 0;
+    tb.m->i_ipal_data = 0;
+    tb.m->i_crc_data = 0;
+    tb.reset(0);
+    tick();
+
+    // Register reads, one given on every clock.
+    int answers = 0;
+    uint64_t start = tb.cycles();
+    tb.m->i_req_space = SPACE_REGS;
+    for (int i = 0; i < REG_READS; i++) {
+        tb.m->i_req_valid = 1;
+        tb.m->i_req_addr = i & 7;
+        tb.m->i_req_tag = i;
+        tick();
+        if (tb.m->o_rsp_valid) {
+            if (tb.m->o_rsp_tag != (answers & 0xFF) ||
+                tb.m->o_rsp_data != (0xA0000000u | (answers & 7))) {
+                printf("readback: wrong answer for register read %d\n", answers);
+                return 1;
+            }
+            answers++;
+        }
+    }
+    tb.m->i_req_valid = 0;
+    result.add("reg_reads_per_clock", (double) answers / (tb.cycles() - start));
+    tick();
+
+    // One frame buffer read.
+    tb.m->i_req_valid = 1;
+    tb.m->i_req_space = SPACE_FRAME;
+    tb.m->i_req_addr = (100 << 8) | 50;
+    tb.m->i_req_tag = 0x77;
+    tick();
+    tb.m->i_req_valid = 0;
+    int latency = 1;
+    while (!tb.m->o_rsp_valid && latency < READ_LIMIT) {
+        tick();
+        latency++;
+    }
+    if (tb.m->o_rsp_tag != 0x77 || tb.m->o_rsp_data != 0x5A) {
+        printf("readback: wrong answer for frame buffer read\n");
+        return 1;
+    }
+    result.add("frame_read_latency_cycles", latency);
+
+    return result.write() ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// bench_string_renderer.cpp
+//
+// Measures the string renderer (string_renderer.v): glyphs drawn per
+// second at the 100 MHz engine clock, and the clocks to draw a whole
+// string, from DRAW until the done pulse. The PSRAM behind the arbiter is
+// modeled here, answering each read after a fixed number of clocks (the
+// read latency measured by bench_psram), the blit port grants every
+// access at once, and the pixels written are checked against the glyphs
+// and widths.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#include <map>
+#include <tuple>
+#include "Vstring_renderer.h"
+#include "bench.h"
+#include "testbench.h"
+
+#define READ_LATENCY    17
+#define CLOCK_HZ        100000000.0
+#define GLYPH_BASE      0x10000
+#define WIDTH_BASE      0x8000
+#define STRING_ADDR     0x4000
+#define FIRST_CODE      0x0100
+#define GLYPHS          16
+#define PEN_X           100
+#define PEN_Y           20
+#define RAMP            0x40
+#define DRAW_LIMIT      (GLYPHS * 20 * (READ_LATENCY + 8))
+
+#define REG_GLYPH_BASE  0
+#define REG_WIDTH_BASE  1
+#define REG_STRING      2
+#define REG_PEN         3
+#define REG_DRAW        4
+
+typedef std::tuple<int, int, int> Pixel; // column, row, palette index
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    Testbench<Vstring_renderer> tb([](Vstring_renderer* m) { return &m->i_clk; },
+                                   [](Vstring_renderer* m) { return &m->i_rst; });
+    BenchResult result("string_renderer");
+
+    // PSRAM: the string, the widths (cycling through narrow and wide
+    // glyphs), and the glyphs, whose alpha codes vary with row and column.
+    static const int widths[] = { 3, 5, 6, 8 };
+    std::map<uint32_t, uint16_t> psram;
+    auto alpha = [](int code, int row, int col) { return (code + row + col) & 0xF; };
+    for (int g = 0; g < GLYPHS; g++) {
+        int code = FIRST_CODE + g;
+        psram[STRING_ADDR + g] = code;
+        psram[WIDTH_BASE + code] = widths[g % 4];
+        for (int row = 0; row < 8; row++) {
+            for (int half = 0; half < 2; half++) {
+                uint16_t word = 0;
+                for (int i = 0; i < 4; i++) {
+                    word |= alpha(code, row, half * 4 + i) << (i * 4);
+                }
+                psram[GLYPH_BASE + code * 16 + row * 2 + half] = word;
+            }
+        }
+    }
+
+    // The pixels that should be written, in drawing order.
+    std::vector<Pixel> expected;
+    int pen = PEN_X;
+    for (int g = 0; g < GLYPHS; g++) {
+        int code = FIRST_CODE + g;
+        for (int row = 0; row < 8; row++) {
+            for (int col = 0; col < widths[g % 4]; col++) {
+                int level = alpha(code, row, col) >> 1;
+                if (level) {
+                    expected.push_back(Pixel(pen + col, PEN_Y + row, RAMP + level));
+                }
+            }
+        }
+        pen += widths[g % 4];
+    }
+
+    // One clock, with the modeled PSRAM answering the request (if any), and
+    // any pixel written collected.
+    std::vector<Pixel> written;
+    int wait = 0;
+    auto tick = [&] {
+        tb.m->i_mem_ack = 0;
+        if (tb.m->o_mem_req) {
+            if (++wait >= READ_LATENCY) {
+                wait = 0;
+                tb.m->i_mem_ack = 1;
+                tb.m->i_mem_data = psram[tb.m->o_mem_addr];
+            }
+        } else {
+            wait = 0;
+        }
+        tb.m->eval();
+        if (tb.m->o_blit_stb) {
+            written.push_back(Pixel(tb.m->o_blit_col, tb.m->o_blit_row, tb.m->o_blit_data));
+        }
+        tb.tick();
+    };
+    auto write_reg = [&](int addr, uint32_t data) {
+        tb.m->i_reg_we = 1;
+        tb.m->i_reg_addr = addr;
+        tb.m->i_reg_data = data;
+        tick();
+        tb.m->i_reg_we = 0;
+    };
+
+    tb.m->i_reg_we = 0;
+    tb.m->i_mem_ack = 0;
+    tb.m->i_blit_grant = 1;
+    tb.reset(0);
+    tick();
+
+    write_reg(REG_GLYPH_BASE, GLYPH_BASE);
+    write_reg(REG_WIDTH_BASE, WIDTH_BASE);
+    write_reg(REG_STRING, STRING_ADDR);
+    write_reg(REG_PEN, (PEN_Y << 16) | PEN_X);
+
+    // Draw the string, and count from DRAW until the done pulse.
+    uint64_t start = tb.cycles();
+    write_reg(REG_DRAW, (RAMP << 16) | GLYPHS);
+    int limit = DRAW_LIMIT;
+    while (!tb.m->o_done && limit-- > 0) {
+        tick();
+    }
+    if (!tb.m->o_done) {
+        printf("string_renderer: the string was not finished\n");
+        return 1;
+    }
+    if (written != expected) {
+        printf("string_renderer: wrong pixels written (%zu, expected %zu)\n",
+               written.size(), expected.size());
+        return 1;
+    }
+    if (tb.m->o_done_tag != (uint32_t) pen) {
+        printf("string_renderer: wrong pen column after the string\n");
+        return 1;
+    }
+    uint64_t clocks = tb.cycles() - start;
+    result.add("glyphs_per_second", GLYPHS * CLOCK_HZ / clocks);
+    result.add("string_cycles", (double) clocks);
+
+    return result.write() ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// bench_text.cpp
+//
+// Measures the text pipeline (text_area8x8.v): commands accepted per
+// command clock, pixels per clock through the text area blender, and the
+// cycles from a background color change to the matching output color.
+// It also checks that a known glyph row comes out at the right pixels.
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#include "Vtext_area8x8.h"
+#include "Vtext_area8x8___024root.h"
+#include "bench.h"
+#include "testbench.h"
+
+#define COMMANDS        64
+#define PIXELS          1000
+#define LATENCY_LIMIT   32
+#define PIXEL_LATENCY   9
+#define CHAR            0x41
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    Testbench<Vtext_area8x8> tb([](Vtext_area8x8* m) { return &m->i_pix_clk; },
+                                [](Vtext_area8x8* m) { return &m->i_rst; });
+    CommandDriver cmd([&] { tb.m->eval(); }, &tb.m->i_cmd_clk, &tb.m->i_cmd_data);
+    BenchResult result("text");
+
+    tb.m->i_blank = 0;
+    tb.m->i_scan_row = 0;
+    tb.m->i_scan_column = 0;
+    tb.m->i_bg_color = 0x000;
+    tb.reset(0);
+
+    // Count how many single command clocks actually change a register.
+    int accepted = 0;
+    int last_x = tb.m->rootp->text_area8x8__DOT__reg_win_scroll_x[0];
+    for (int i = 1; i <= COMMANDS; i++) {
+        cmd.clock(0x10000000 | i); // set horizontal scroll position
+        int x = tb.m->rootp->text_area8x8__DOT__reg_win_scroll_x[0];
+        if (x != last_x) {
+            accepted++;
+            last_x = x;
+        }
+    }
+    result.add("commands_per_clock", (double) accepted / COMMANDS);
+
+    // With the text area fully transparent, the output is the background.
+    cmd.send(0x60000000); // text area alpha = 0%
+    tb.ticks(LATENCY_LIMIT);
+
+    tb.m->i_bg_color = 0xFFF;
+    int latency = tb.wait_until([&] { return tb.m->o_color == 0xFFF; },
+                                LATENCY_LIMIT);
+    result.add("bg_latency_cycles", latency);
+
+    int changes = 0;
+    int last_color = tb.m->o_color;
+    for (int i = 0; i < PIXELS; i++) {
+        tb.m->i_bg_color = (i & 1) ? 0xFFF : 0x000;
+        tb.tick();
+        if (tb.m->o_color != last_color) {
+            changes++;
+            last_color = tb.m->o_color;
+        }
+    }
+    result.add("pixels_per_clock", (double) changes / PIXELS);
+
+    // Row 0 of a glyph, in white over black in cell (0, 0), with the cell
+    // after it all black, should be shown at scan columns 0 to 7. Column 7
+    // is opaque, so a glyph drawn one pixel off shows the next cell there.
+    const uint8_t row[8] = { 0xF, 0x0, 0x0, 0x0, 0xF, 0xF, 0x0, 0xF };
+    preload(tb.m->rootp->text_area8x8__DOT__char_blender_inst__DOT__char_gen_inst__DOT__glyphs,
+            row, 8, CHAR * 64);
+    const uint32_t cells[2] = { 0x00F000 | CHAR, 0x000000 | CHAR };
+    preload(tb.m->rootp->text_area8x8__DOT__text_array8x8_inst__DOT__memory,
+            cells, 1, 0);
+    preload(tb.m->rootp->text_area8x8__DOT__text_array8x8_inst__DOT__memory,
+            cells + 1, 1, 64);
+    cmd.send({
+        0x10000000, // window 0 at scroll position 0
+        0x6000000F, // text area alpha = 100%
+        0x4000FFFF, // FG palette color 15 = white
+        0x50000000  // BG palette color 0 = black
+    });
+    tb.m->i_bg_color = 0x000;
+
+    std::vector<int> colors;
+    for (int column = 0; column < 16 + PIXEL_LATENCY; column++) {
+        tb.m->i_scan_column = column;
+        tb.tick();
+        colors.push_back(tb.m->o_color);
+    }
+    for (int column = 0; column < 16; column++) {
+        int expected = (column < 8 && row[column]) ? 0xFFF : 0x000;
+        if (colors[column + PIXEL_LATENCY - 1] != expected) {
+            printf("text: wrong color at scan column %d (%03X, expected %03X)\n",
+                   column, colors[column + PIXEL_LATENCY - 1], expected);
+            return 1;
+        }
+    }
+
+    return result.write() ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#!/bin/sh
+#
+# compare.sh
+#
+# Compares each results/<bench>.json against baseline/<bench>.json.
+# Values whose names end in "_per_clock" or "_per_second" are throughputs,
+# and regress when they drop below the baseline by more than the tolerance.
+# All other values are latencies or costs, and regress when they rise above
+# the baseline by more than the tolerance. The tolerance is a fraction (default 0.05).
+#
+# Exits non-zero if any value regressed, or if a baseline value is missing
+# from the results. A bench with no baseline yet is only reported.
+#
+# Copyright (C) 2024 Curtis Whitley
+# License: APACHE
+#
+
+TOLERANCE=${1:-0.05}
+status=0
+
+for result in results/*.json; do
+    bench=$(basename "$result" .json)
+    baseline="baseline/${bench}.json"
+    if [ ! -f "$baseline" ]; then
+        echo "$bench: no baseline (run make bench-baseline)"
+        continue
+    fi
+    awk -v tol="$TOLERANCE" -v bench="$bench" '
+        function pairs(line) {
+            if (match(line, /"[a-z_0-9]+": *[-0-9.]+/)) {
+                split(substr(line, RSTART, RLENGTH), kv, /": */)
+                key = substr(kv[1], 2)
+                return 1
+            }
+            return 0
+        }
+        FNR == NR { if (pairs($0)) base[key] = kv[2] + 0; next }
+        { if (pairs($0)) cur[key] = kv[2] + 0 }
+        END {
+            bad = 0
+            for (key in base) {
+                if (!(key in cur)) {
+                    printf "%-8s %-32s missing\n", bench, key
+                    bad = 1
+                    continue
+                }
+                b = base[key]; c = cur[key]
+                if (key ~ /_per_(clock|second)$/)
+                    fail = (c < b * (1 - tol))
+                else
+                    fail = (c > b * (1 + tol))
+                printf "%-8s %-32s %10.4f %10.4f %s\n", bench, key, b, c, \
+                    fail ? "REGRESSED" : "ok"
+                if (fail) bad = 1
+            }
+            exit bad
+        }
+    ' "$baseline" "$result" || status=1
+done
+
+exit $status
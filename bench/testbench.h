@@ -0,0 +1,224 @@
+// testbench.h
+//
+// A small testbench framework over Verilator, for module unit tests and
+// benchmarks in this directory. It provides:
+//
+//  Testbench<MODULE>  clock and reset helpers, and cycle counting
+//  CommandDriver      drives the i_cmd_clk/i_cmd_data command port
+//  preload()          fills a memory inside the model directly, from an
+//                     array or a raw binary file (no $readmemh parsing)
+//  StateCoverage      reports which psram.v states were hit, from the
+//                     states_hit output
+//
+// Models must be built with --public-flat-rw for preload() to reach the
+// memories (the bench Makefile does this).
+//
+// Copyright (C) 2024 Curtis Whitley
+// License: APACHE
+
+#ifndef _TESTBENCH_H_
+#define _TESTBENCH_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "verilated.h"
+
+template <class MODULE>
+class Testbench {
+public:
+    // The clock and reset ports are picked from the new model by the given
+    // functions, since port names differ between modules (i_clk, i_pix_clk).
+    explicit Testbench(std::function<CData*(MODULE*)> clk,
+                       std::function<CData*(MODULE*)> rst = nullptr,
+                       bool rst_active_high = true) :
+        m(new MODULE), m_rst_active_high(rst_active_high), m_cycles(0) {
+        m_clk = clk(m);
+        m_rst = rst ? rst(m) : nullptr;
+        *m_clk = 0;
+        m->eval();
+    }
+
+    ~Testbench() {
+        m->final();
+        delete m;
+    }
+
+    // One full clock: falling edge, then rising edge.
+    void tick() {
+        *m_clk = 0;
+        m->eval();
+        *m_clk = 1;
+        m->eval();
+        m_cycles++;
+    }
+
+    void ticks(int count) {
+        for (int i = 0; i < count; i++) {
+            tick();
+        }
+    }
+
+    // Holds reset for the given number of clocks. With no clocks, the reset
+    // is only pulsed (for modules that reset on the reset edge).
+    void reset(int clocks = 1) {
+        if (!m_rst) return;
+        *m_rst = m_rst_active_high ? 0 : 1;
+        m->eval();
+        *m_rst = m_rst_active_high ? 1 : 0;
+        m->eval();
+        ticks(clocks);
+        *m_rst = m_rst_active_high ? 0 : 1;
+        m->eval();
+    }
+
+    // Clocks until the condition is true, and returns the number of clocks
+    // taken, or -1 if the limit was reached first. The condition is checked
+    // before the first clock, so 0 means it was already true.
+    int wait_until(std::function<bool()> condition, int limit) {
+        for (int i = 0; i <= limit; i++) {
+            if (condition()) return i;
+            if (i < limit) tick();
+        }
+        return -1;
+    }
+
+    uint64_t cycles() const { return m_cycles; }
+
+    MODULE* m;
+
+private:
+    CData* m_clk;
+    CData* m_rst;
+    bool m_rst_active_high;
+    uint64_t m_cycles;
+};
+
+// Drives the command port shared by text_area8x8 and canvas. The command
+// logic in those modules handles a command on one rising edge of i_cmd_clk
+// and recovers on the next, so each command takes two command clocks.
+class CommandDriver {
+public:
+    CommandDriver(std::function<void()> eval, CData* cmd_clk, IData* cmd_data) :
+        m_eval(eval), m_cmd_clk(cmd_clk), m_cmd_data(cmd_data),
+        m_clocks(0), m_commands(0) {}
+
+    // A single command clock with the given data.
+    void clock(uint32_t data) {
+        *m_cmd_data = data;
+        *m_cmd_clk = 0;
+        m_eval();
+        *m_cmd_clk = 1;
+        m_eval();
+        *m_cmd_clk = 0;
+        m_eval();
+        m_clocks++;
+    }
+
+    // A complete command, in whichever phase the module is in.
+    void send(uint32_t data) {
+        clock(data);
+        clock(data);
+        m_commands++;
+    }
+
+    void send(const std::vector<uint32_t>& commands) {
+        for (uint32_t c : commands) {
+            send(c);
+        }
+    }
+
+    uint64_t clocks() const { return m_clocks; }
+    uint64_t commands() const { return m_commands; }
+
+private:
+    std::function<void()> m_eval;
+    CData* m_cmd_clk;
+    IData* m_cmd_data;
+    uint64_t m_clocks;
+    uint64_t m_commands;
+};
+
+// Copies values straight into a memory array inside the model, for example
+// tb.m->rootp->frame_buffer__DOT__cells, starting at the given index.
+template <class ARRAY, class T>
+void preload(ARRAY& memory, const T* data, size_t count, size_t offset = 0) {
+    for (size_t i = 0; i < count; i++) {
+        memory[offset + i] = data[i];
+    }
+}
+
+template <class ARRAY, class T>
+void preload(ARRAY& memory, const std::vector<T>& data, size_t offset = 0) {
+    preload(memory, data.data(), data.size(), offset);
+}
+
+// Reads a raw binary file (one byte per memory entry), such as the output
+// of the image converters, without any text parsing.
+inline std::vector<uint8_t> load_binary(const char* path) {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("Cannot open %s\n", path);
+        return data;
+    }
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    return data;
+}
+
+// Reports coverage of the psram.v state machine, from its states_hit output
+// (one bit per MachineState value).
+class StateCoverage {
+public:
+    StateCoverage(const char* const* names, int count) :
+        m_names(names), m_count(count) {}
+
+    int hit(uint64_t states_hit) const {
+        int n = 0;
+        for (int i = 0; i < m_count; i++) {
+            if (states_hit & (1ULL << i)) n++;
+        }
+        return n;
+    }
+
+    int missed(uint64_t states_hit) const {
+        return m_count - hit(states_hit);
+    }
+
+    void print(uint64_t states_hit) const {
+        printf("state coverage: %d of %d\n", hit(states_hit), m_count);
+        for (int i = 0; i < m_count; i++) {
+            if (!(states_hit & (1ULL << i))) {
+                printf("  not hit: %s\n", m_names[i]);
+            }
+        }
+    }
+
+private:
+    const char* const* m_names;
+    int m_count;
+};
+
+// The MachineState names from psram.v, in order.
+static const char* const psram_state_names[] = {
+    "RESET_JUST_NOW", "RESET_CLOCK_WAIT", "RESET_CLOCK_DONE",
+    "MODE_SELECT_CMD_7", "MODE_CMD_6", "MODE_CMD_5", "MODE_CMD_4",
+    "MODE_CMD_3", "MODE_CMD_2", "MODE_CMD_1", "MODE_CMD_0", "MODE_DESELECT",
+    "IDLE",
+    "READ_CMD_3_0", "READ_ADDR_23_20", "READ_ADDR_19_16", "READ_ADDR_15_12",
+    "READ_ADDR_11_8", "READ_ADDR_7_4", "READ_ADDR_3_0", "READ_WAIT",
+    "READ_DATA_7_4", "READ_DATA_3_0", "READ_DESELECT",
+    "WRITE_CMD_3_0", "WRITE_ADDR_23_20", "WRITE_ADDR_19_16",
+    "WRITE_ADDR_15_12", "WRITE_ADDR_11_8", "WRITE_ADDR_7_4",
+    "WRITE_ADDR_3_0", "WRITE_DATA_7_4", "WRITE_DATA_3_0", "WRITE_DESELECT"
+};
+#define PSRAM_STATE_COUNT \
+    ((int) (sizeof(psram_state_names) / sizeof(psram_state_names[0])))
+
+#endif // _TESTBENCH_H_
@@ -15,7 +15,7 @@
 
 int main() {
     for (int i=0; i<CHAR_WIDTH*CHAR_HEIGHT*32; i++) {
-        printf("000\n");
+        printf("0000\n");
     }
 
     for (int row=0; row<INPUT_ROWS; row++) {
@@ -30,15 +30,19 @@ int main() {
                     //printf("%i %i %i %i -> %i (%04X)\n",row,col,srow,scol,index,index);
                     const unsigned char* p = &gfont8x8_Data[index];
 
-                    if (p[1]==0x00)
-                        printf("110\n"); // 100% opaque
-                    else
-                        printf("000\n"); // 0% opaque
+                    // The glyph is drawn dark on light, so the alpha is the
+                    // inverted gray level, reduced to 4 bits (0 = 0% opaque,
+                    // 15 = 100% opaque). Anti-aliased edges are kept.
+                    int alpha = 15 - (p[1] >> 4);
+                    for (int bit=3; bit>=0; bit--) {
+                        putchar((alpha & (1 << bit)) ? '1' : '0');
+                    }
+                    putchar('\n');
                 }
             }
         }
     }
     for (int i=0; i<CHAR_WIDTH*CHAR_HEIGHT*128; i++) {
-        printf("000\n");
+        printf("0000\n");
     }
 }
\ No newline at end of file
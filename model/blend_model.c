@@ -0,0 +1,63 @@
+// Host reference model for the OGEGE color blender.
+//
+// Build the table generator with:
+//   gcc -DBLEND_MODEL_MAIN blend_model.c -o blend_model -lm
+// and run it to print the constants used by src/gamma_blender.v.
+
+#include "blend_model.h"
+
+const uint8_t blend_linearize[16] = {
+    0, 1, 3, 7, 14, 23, 34, 48, 64, 83, 105, 129, 156, 186, 219, 255
+};
+
+const uint8_t blend_delinearize_threshold[15] = {
+    1, 2, 5, 11, 19, 29, 41, 56, 74, 94, 117, 143, 171, 203, 237
+};
+
+// round((fg*alpha + bg*(15-alpha)) / 15), for 4-bit components.
+uint8_t blend_component_linear(uint8_t bg, uint8_t fg, uint8_t alpha) {
+    uint32_t sum = fg * alpha + bg * (15 - alpha);
+    return (uint8_t) (((sum << 4) + sum + 136) >> 8);
+}
+
+// Same weighting, but done on linear light values.
+uint8_t blend_component_gamma(uint8_t bg, uint8_t fg, uint8_t alpha) {
+    uint32_t sum = blend_linearize[fg] * alpha + blend_linearize[bg] * (15 - alpha);
+    uint32_t mix = (sum * 273 + 2166) >> 12; // round(sum / 15), 0..255
+    uint8_t color = 0;
+    for (int i = 0; i < 15; i++) {
+        if (mix >= blend_delinearize_threshold[i]) {
+            color++;
+        }
+    }
+    return color;
+}
+
+uint16_t blend_color(uint16_t bg, uint16_t fg, uint8_t alpha, int gamma) {
+    uint16_t color = 0;
+    for (int shift = 8; shift >= 0; shift -= 4) {
+        uint8_t b = (bg >> shift) & 0xF;
+        uint8_t f = (fg >> shift) & 0xF;
+        uint8_t c = gamma ? blend_component_gamma(b, f, alpha) :
+                            blend_component_linear(b, f, alpha);
+        color |= c << shift;
+    }
+    return color;
+}
+
+#ifdef BLEND_MODEL_MAIN
+#include <math.h>
+#include <stdio.h>
+
+int main() {
+    int lin[16];
+    for (int c = 0; c < 16; c++) {
+        lin[c] = (int) lround(255.0 * pow(c / 15.0, 2.2));
+        printf("4'h%X: linearize = 8'd%d;\n", c, lin[c]);
+    }
+    for (int c = 1; c < 16; c++) {
+        printf("threshold %d = 8'd%d\n", c, (lin[c - 1] + lin[c] + 1) / 2);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,26 @@
+// Host reference model for the OGEGE color blender.
+//
+// These functions compute exactly the same results as the Verilog in
+// src/component_blender.v and src/gamma_blender.v, so that host code and
+// regression scenes can predict what the hardware will output.
+//
+// Colors are 12 bits (RRRRGGGGBBBB). Alpha is the 4-bit linear code used
+// everywhere in the engine (0 = 0% opaque, 15 = 100% opaque).
+
+#ifndef _BLEND_MODEL_H_
+#define _BLEND_MODEL_H_
+
+#include <stdint.h>
+
+// Gamma-encoded 4-bit component to 8-bit linear light (gamma 2.2).
+extern const uint8_t blend_linearize[16];
+
+// Linear light thresholds: a linear value v delinearizes to the number of
+// entries in this table that are less than or equal to v.
+extern const uint8_t blend_delinearize_threshold[15];
+
+uint8_t blend_component_linear(uint8_t bg, uint8_t fg, uint8_t alpha);
+uint8_t blend_component_gamma(uint8_t bg, uint8_t fg, uint8_t alpha);
+uint16_t blend_color(uint16_t bg, uint16_t fg, uint8_t alpha, int gamma);
+
+#endif // _BLEND_MODEL_H_
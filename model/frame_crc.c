@@ -0,0 +1,52 @@
+// Host reference model for the OGEGE frame signature.
+//
+// Build the self check with:
+//   gcc -DFRAME_CRC_MAIN frame_crc.c -o frame_crc
+// It checks the CRC against the standard CRC32 check value, by feeding
+// the bytes of "123456789" through the same bit-serial update.
+
+#include "frame_crc.h"
+
+static uint32_t frame_crc_bits(uint32_t crc, uint32_t data, int bits) {
+    for (int b = 0; b < bits; b++) {
+        if ((crc ^ (data >> b)) & 1) {
+            crc = (crc >> 1) ^ 0xEDB88320;
+        } else {
+            crc >>= 1;
+        }
+    }
+    return crc;
+}
+
+uint32_t frame_crc_add(uint32_t crc, uint16_t color) {
+    return frame_crc_bits(crc, color & 0xFFF, 12);
+}
+
+uint32_t frame_crc(const uint16_t* frame, int left, int right, int top, int bottom) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (int row = top; row < bottom && row < FRAME_CRC_HEIGHT; row++) {
+        for (int col = left; col < right && col < FRAME_CRC_WIDTH; col++) {
+            crc = frame_crc_add(crc, frame[row * FRAME_CRC_WIDTH + col]);
+        }
+    }
+    return ~crc;
+}
+
+#ifdef FRAME_CRC_MAIN
+#include <stdio.h>
+
+int main() {
+    const char* check = "123456789";
+    uint32_t crc = 0xFFFFFFFF;
+    for (const char* c = check; *c; c++) {
+        crc = frame_crc_bits(crc, (uint8_t) *c, 8);
+    }
+    crc = ~crc;
+    if (crc != 0xCBF43926) {
+        printf("CRC32 check value is %08X, not CBF43926\n", crc);
+        return 1;
+    }
+    printf("CRC32 check value matches\n");
+    return 0;
+}
+#endif
@@ -0,0 +1,28 @@
+// Host reference model for the OGEGE frame signature.
+//
+// These functions compute exactly the same CRC as src/frame_crc.v, so
+// that regression scenes rendered by a software model of the engine can
+// be matched against the CRC read back from the board, once per frame.
+//
+// Colors are 12 bits (RRRRGGGGBBBB). The CRC is the usual CRC32 (bit
+// reflected, polynomial 0xEDB88320, start 0xFFFFFFFF, final complement),
+// fed with the 12 bits of each pixel in the region, lowest bit first,
+// left to right and top to bottom.
+
+#ifndef _FRAME_CRC_H_
+#define _FRAME_CRC_H_
+
+#include <stdint.h>
+
+#define FRAME_CRC_WIDTH     640
+#define FRAME_CRC_HEIGHT    480
+
+// Adds one pixel to a CRC in progress (start with 0xFFFFFFFF).
+uint32_t frame_crc_add(uint32_t crc, uint16_t color);
+
+// The finished CRC of a whole frame (FRAME_CRC_WIDTH x FRAME_CRC_HEIGHT
+// colors, row by row), over the pixels from left up to right, and from
+// top up to bottom, as set in the COLUMNS and ROWS registers.
+uint32_t frame_crc(const uint16_t* frame, int left, int right, int top, int bottom);
+
+#endif // _FRAME_CRC_H_
@@ -0,0 +1,96 @@
+// Host reference model for the OGEGE inverse palette.
+//
+// Build the self check with:
+//   gcc -DINVERSE_PALETTE_MAIN inverse_palette.c -o inverse_palette
+// and run it with a palette file (such as ../image/car336x256x256.pal) to
+// check that incremental passes give the same table as a whole generation.
+
+#include "inverse_palette.h"
+
+uint16_t ipal_distance(uint16_t a, uint16_t b) {
+    uint16_t sum = 0;
+    for (int shift = 8; shift >= 0; shift -= 4) {
+        int d = ((a >> shift) & 0xF) - ((b >> shift) & 0xF);
+        sum += d * d;
+    }
+    return sum;
+}
+
+uint8_t ipal_nearest(const uint16_t palette[IPAL_ENTRIES], uint16_t color) {
+    uint8_t best = 0;
+    uint16_t best_d = ipal_distance(color, palette[0]);
+    for (int e = 1; e < IPAL_ENTRIES; e++) {
+        uint16_t d = ipal_distance(color, palette[e]);
+        if (d < best_d) {
+            best = e;
+            best_d = d;
+        }
+    }
+    return best;
+}
+
+void ipal_generate(const uint16_t palette[IPAL_ENTRIES], uint8_t table[IPAL_COLORS]) {
+    for (int c = 0; c < IPAL_COLORS; c++) {
+        table[c] = ipal_nearest(palette, c);
+    }
+}
+
+// Colors the changed entry owned may now be nearer to another entry, so
+// they are compared with every entry again; all other colors only need to
+// be compared with the changed entry.
+int ipal_update(const uint16_t palette[IPAL_ENTRIES], uint8_t table[IPAL_COLORS],
+                uint8_t entry) {
+    int rescans = 0;
+    for (int c = 0; c < IPAL_COLORS; c++) {
+        uint8_t n = table[c];
+        if (n == entry) {
+            table[c] = ipal_nearest(palette, c);
+            rescans++;
+        } else {
+            uint16_t d_old = ipal_distance(c, palette[n]);
+            uint16_t d_new = ipal_distance(c, palette[entry]);
+            if (d_new < d_old || (d_new == d_old && entry < n)) {
+                table[c] = entry;
+            }
+        }
+    }
+    return rescans;
+}
+
+#ifdef INVERSE_PALETTE_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char** argv) {
+    uint16_t palette[IPAL_ENTRIES] = { 0 };
+    uint8_t table[IPAL_COLORS];
+    uint8_t check[IPAL_COLORS];
+    if (argc > 1) {
+        FILE* f = fopen(argv[1], "r");
+        if (!f) {
+            printf("Cannot open %s\n", argv[1]);
+            return 1;
+        }
+        unsigned int color;
+        for (int e = 0; e < IPAL_ENTRIES && fscanf(f, "%x", &color) == 1; e++) {
+            palette[e] = color & 0xFFF;
+        }
+        fclose(f);
+    }
+    ipal_generate(palette, table);
+    srand(1);
+    for (int i = 0; i < 1000; i++) {
+        uint8_t entry = rand() % IPAL_ENTRIES;
+        palette[entry] = rand() % IPAL_COLORS;
+        ipal_update(palette, table, entry);
+    }
+    ipal_generate(palette, check);
+    if (memcmp(table, check, sizeof(table)) != 0) {
+        printf("Incremental passes differ from a whole generation\n");
+        return 1;
+    }
+    printf("Incremental passes match a whole generation\n");
+    return 0;
+}
+#endif
@@ -0,0 +1,33 @@
+// Host reference model for the OGEGE inverse palette.
+//
+// These functions compute exactly the same table as src/inverse_palette.v,
+// so that host code can find palette indexes for RGB colors (drawing in
+// RGB, remapping converted images) the way the engine does.
+//
+// Colors are 12 bits (RRRRGGGGBBBB). The table has one palette index for
+// each of the 4096 colors: the entry with the smallest squared distance,
+// and the lowest index of those that tie.
+
+#ifndef _INVERSE_PALETTE_H_
+#define _INVERSE_PALETTE_H_
+
+#include <stdint.h>
+
+#define IPAL_ENTRIES    256
+#define IPAL_COLORS     4096
+
+// dr*dr + dg*dg + db*db, on the 4-bit components.
+uint16_t ipal_distance(uint16_t a, uint16_t b);
+
+// The entry nearest to one color.
+uint8_t ipal_nearest(const uint16_t palette[IPAL_ENTRIES], uint16_t color);
+
+// The whole table.
+void ipal_generate(const uint16_t palette[IPAL_ENTRIES], uint8_t table[IPAL_COLORS]);
+
+// Updates the table after palette[entry] has changed (an incremental pass).
+// Returns the number of colors that had to be compared with every entry.
+int ipal_update(const uint16_t palette[IPAL_ENTRIES], uint8_t table[IPAL_COLORS],
+                uint8_t entry);
+
+#endif // _INVERSE_PALETTE_H_
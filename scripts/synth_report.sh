@@ -0,0 +1,86 @@
+#!/bin/sh
+#
+# synth_report.sh
+#
+# Prints a table of resource counts and estimated fmax for each module
+# synthesized out of context by "make synth_modules" (see Makefile).
+#
+# For each module name given, this reads:
+#
+#   <module>_stat.log   yosys "stat" output (cell counts)
+#   <module>_ltp.log    yosys "ltp -noff" output (logic levels between FFs)
+#   <module>_pr.log     optional p_r log, if the module was placed and routed
+#
+# The fmax column comes from the p_r timing report when one exists. Otherwise
+# it is a rough estimate from the longest path in cells, using NS_PER_LEVEL
+# nanoseconds per CPE level (routing included) plus NS_FF for the register,
+# and is marked with a "~". The estimate is meant for comparing one change
+# against another, not as a timing sign-off.
+#
+# Copyright (C) 2024 Curtis Whitley
+# License: APACHE
+#
+
+NS_PER_LEVEL=${NS_PER_LEVEL:-1.8}
+NS_FF=${NS_FF:-1.5}
+
+if [ $# -eq 0 ]; then
+    echo "Use: synth_report.sh <module> [<module> ...]"
+    exit 1
+fi
+
+printf "%-20s %7s %7s %7s %8s %8s %7s %10s\n" \
+    "Module" "LUT" "MUX" "FF" "ADDF" "BRAM20K" "Levels" "Fmax(MHz)"
+printf "%-20s %7s %7s %7s %8s %8s %7s %10s\n" \
+    "------" "---" "---" "--" "----" "-------" "------" "---------"
+
+for module in "$@"; do
+    stat="${module}_stat.log"
+    ltp="${module}_ltp.log"
+    pr="${module}_pr.log"
+
+    if [ ! -f "$stat" ]; then
+        printf "%-20s %s\n" "$module" "(no ${stat}; run make synth_modules)"
+        continue
+    fi
+
+    # Accept both "CC_DFF  12" and "12  CC_DFF" forms of the stat output.
+    # A 40K BRAM counts as two 20K blocks.
+    counts=$(awk '
+        $1 ~ /^CC_/ && $2 ~ /^[0-9]+$/ { cell = $1; n = $2 }
+        $2 ~ /^CC_/ && $1 ~ /^[0-9]+$/ { cell = $2; n = $1 }
+        cell != "" {
+            if (cell ~ /^CC_(LUT|L2T)/) lut += n
+            else if (cell ~ /^CC_MX/) mux += n
+            else if (cell ~ /^CC_(DFF|DLT)/) ff += n
+            else if (cell ~ /^CC_ADDF/) addf += n
+            else if (cell ~ /^CC_BRAM_20K/) bram += n
+            else if (cell ~ /^CC_BRAM_40K/) bram += 2 * n
+            cell = ""
+        }
+        END { printf "%d %d %d %d %d", lut, mux, ff, addf, bram }
+    ' "$stat")
+    read lut mux ff addf bram <<END
+$counts
+END
+
+    levels="-"
+    if [ -f "$ltp" ]; then
+        levels=$(sed -n 's/.*length=\([0-9][0-9]*\).*/\1/p' "$ltp" | tail -1)
+        [ -z "$levels" ] && levels="-"
+    fi
+
+    fmax="-"
+    if [ -f "$pr" ]; then
+        fmax=$(grep -i "maximum clock frequency" "$pr" | \
+            sed -n 's/.*[^0-9.]\([0-9][0-9]*\.[0-9]*\) *MHz.*/\1/p' | head -1)
+        [ -z "$fmax" ] && fmax="-"
+    fi
+    if [ "$fmax" = "-" ] && [ "$levels" != "-" ]; then
+        fmax=$(awk -v l="$levels" -v d="$NS_PER_LEVEL" -v f="$NS_FF" \
+            'BEGIN { printf "~%.1f", 1000.0 / (l * d + f) }')
+    fi
+
+    printf "%-20s %7d %7d %7d %8d %8d %7s %10s\n" \
+        "$module" "$lut" "$mux" "$ff" "$addf" "$bram" "$levels" "$fmax"
+done
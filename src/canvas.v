@@ -5,6 +5,42 @@
  * based on the given screen position (scan row and column),
  * and the canvas scroll position. 
  *
+ * Port B of the frame buffer runs on the 100 MHz memory clock, which
+ * ticks 4 times per pixel clock, and is time-sliced between the display
+ * and a write/blit client. In each pixel clock, one slot (pixel phase 1)
+ * reads the byte for the display, and the other 3 slots are given to the
+ * blit port. The display byte is held in a register until the next pixel
+ * clock, where it addresses the palette. So, o_color is valid 1 pixel
+ * clock after the scan position is given, and the blit port gets 75 MHz
+ * of frame buffer bandwidth without ever disturbing the display.
+ *
+ * In the 320x240 modes, each canvas pixel covers 2x2 screen pixels. The
+ * display slot then reads the frame buffer only for the first screen pixel
+ * of each canvas pixel, on the first screen line of each canvas row, and
+ * keeps the byte in a line buffer. The repeated screen line is replayed
+ * from the line buffer, so each source row is read from the frame buffer
+ * once, and every slot that the display does not need goes to the blit
+ * port. The caller tells which pixels are repeats with i_repeat_row (odd
+ * screen line) and i_repeat_column (odd screen pixel); both are 0 in the
+ * 640-pixel-wide modes.
+ *
+ * The canvas is only shown inside its clip rectangle, given in scan
+ * positions (i_scan_row, i_scan_column). Outside it, the display slot does
+ * not read the frame buffer (the slot goes to the blit port), and the
+ * clip palette index is shown instead, so the canvas can be shown as a
+ * picture inside a border. The clip rectangle covers the whole screen by
+ * default.
+ *
+ * The blit port is in the memory clock domain. When i_blit_stb is high,
+ * o_blit_grant tells whether the access is taken on this clock edge. For
+ * a read, o_blit_valid goes high on the next clock, with the byte on
+ * o_blit_data.
+ *
+ * A READ command for space 3 reads a palette entry (see readback.v). The
+ * entry is on o_rd_data, with the command's tag, once the command ends
+ * (o_rd_valid goes high on the command clock that ends the command, and
+ * stays high until the next command starts).
+ *
  * Copyright (C) 2024 Curtis Whitley
  * License: APACHE
  */
@@ -14,33 +50,80 @@
 module canvas (
     input  wire i_rst,
     input  wire i_pix_clk,
+    input  wire i_mem_clk,
+    input  wire [1:0] i_pix_phase,
     input  wire i_blank,
     input  wire i_cmd_clk,
     input  wire [31:0] i_cmd_data,
     input  wire [8:0] i_scan_row,
     input  wire [9:0] i_scan_column,
-    output wire [11:0] o_color
+    input  wire i_repeat_row,
+    input  wire i_repeat_column,
+    output wire [11:0] o_color,
+    input  wire i_blit_stb,
+    input  wire i_blit_we,
+    input  wire [8:0] i_blit_col,
+    input  wire [7:0] i_blit_row,
+    input  wire [7:0] i_blit_data,
+    output wire o_blit_grant,
+    output reg  o_blit_valid,
+    output wire [7:0] o_blit_data,
+    output reg  o_rd_valid,
+    output wire [31:0] o_rd_data
 );
 
-    // The color palette each holds 256 colors at 12 bits each (4 bits per
+    // The color palette holds 256 colors at 12 bits each (4 bits per
     // color component), since 12 bits is all that the board supports.
+    // It lives in BRAM (see palette.v), and is read through a register
+    // in the pixel path, rather than through a 256-way multiplexer.
+    //
+    reg reg_pal_wea;
+    reg [7:0] reg_pal_addra;
+    reg [11:0] reg_pal_dia;
+    wire [11:0] wire_pal_doa;
+    wire [11:0] wire_pal_dob;
+
+    // A palette read in progress, and the tag to answer it with.
     //
-    reg [11:0] reg_palette_color[0:255];
+    localparam READ_SPACE = 4'd3;
+    reg reg_rd_pending;
+    reg [7:0] reg_rd_tag;
 
     // The scroll offsets default to zero, which means that the upper-left
     // visible pixel is the upper-left pixel in the text cell for text row 0
     // and text column 0.
     //
+    // The offsets are kept inside the frame buffer (X below 336, and Y
+    // below 256), so a single wrap of the scrolled position is enough.
+    //
     reg [9:0] reg_scroll_x_offset;
     reg [8:0] reg_scroll_y_offset;
 
+    function [9:0] ring_column;
+        input [9:0] x;
+        begin
+            ring_column = (x >= 1008) ? (x - 1008) :
+                          (x >= 672) ? (x - 672) :
+                          (x >= 336) ? (x - 336) : x;
+        end
+    endfunction
+
+    // The clip rectangle covers scan positions from (left, top) up to,
+    // but not including, (right, bottom).
+    //
+    reg [9:0] reg_clip_left;
+    reg [9:0] reg_clip_right;
+    reg [8:0] reg_clip_top;
+    reg [8:0] reg_clip_bottom;
+    reg [7:0] reg_clip_index;
+
     reg reg_cmd_in_progress;
     reg reg_wea;
-    reg reg_web;
+    wire wire_web;
     reg reg_clka;
     wire wire_clkb;
     reg [7:0] reg_dia;
-    reg [7:0] reg_dib;
+    wire [7:0] wire_dib;
     reg [8:0] reg_cola;
     wire [8:0] wire_colb;
     reg [7:0] reg_rowa;
@@ -48,13 +131,35 @@ module canvas (
     reg [7:0] reg_doa;
     reg [7:0] reg_dob;
 
+    // The display fetch slot, and the byte it fetched, which is held
+    // steady for the pixel clock domain.
+    //
+    localparam DISPLAY_PHASE = 2'd1;
+    wire display_slot;
+    wire display_fetch;
+    wire display_replay;
+    wire display_clipped;
+    wire in_clip;
+    reg reg_display_fetched;
+    reg reg_display_replayed;
+    reg reg_display_clipped;
+    reg [7:0] reg_display_index;
+    wire [8:0] display_col;
+    wire [7:0] display_row;
+
+    // The line buffer holds one source row, indexed by canvas column.
+    //
+    reg [7:0] line_buffer [0:511];
+    reg [8:0] reg_line_column;
+    reg [7:0] reg_line_data;
+
     frame_buffer frame_buffer_inst (
         .wea(reg_wea),
-        .web(reg_web),
+        .web(wire_web),
         .clka(reg_clka),
         .clkb(wire_clkb),
         .dia(reg_dia),
-        .dib(reg_dib),
+        .dib(wire_dib),
         .cola(reg_cola),
         .rowa(reg_rowa),
         .colb(wire_colb),
@@ -63,9 +168,21 @@ module canvas (
         .dob(reg_dob)
     );
 
-    initial begin
-        $readmemh("../image/car336x256x256.pal", reg_palette_color, 0, 255);
-    end
+    palette #(
+        .ADDR_WIDTH(8),
+        .INIT_FILE("../image/car336x256x256.pal")
+    ) palette_inst (
+        .wea(reg_pal_wea),
+        .web(1'b0),
+        .clka(i_cmd_clk),
+        .clkb(i_pix_clk),
+        .dia(reg_pal_dia),
+        .dib(12'd0),
+        .addra(reg_pal_addra),
+        .addrb(reg_display_index),
+        .doa(wire_pal_doa),
+        .dob(wire_pal_dob)
+    );
 
     wire [9:0] adjusted_scan_row;
     wire [10:0] adjusted_scan_column;
@@ -74,36 +191,149 @@ module canvas (
 
     wire [7:0] cell_value;
 
+    // The frame buffer is a ring of 336x256 pixels, so the scrolled
+    // position wraps around at its edges.
+    //
     assign adjusted_scan_row = {1'b0,i_scan_row} + {1'b0,reg_scroll_y_offset};
-    assign wrapped_scan_row = adjusted_scan_row >= 672 ?
-        adjusted_scan_row - 672 : adjusted_scan_row;
+    assign wrapped_scan_row = adjusted_scan_row >= 256 ?
+        adjusted_scan_row - 256 : adjusted_scan_row;
 
     assign adjusted_scan_column = {1'b0,i_scan_column} + {1'b0,reg_scroll_x_offset};
-    assign wrapped_scan_column = adjusted_scan_column >= 512 ?
-        adjusted_scan_column - 512 : adjusted_scan_column;
-
-    assign wire_colb = wrapped_scan_column[9:0];
-    assign wire_rowb = wrapped_scan_row[8:0];
-    //assign reg_web = 0;
-    assign wire_clkb = i_pix_clk;
-
-    assign o_color = reg_palette_color[reg_dob];
-
-    always @(posedge i_rst) begin
-        reg_scroll_x_offset <= 0;
-        reg_scroll_y_offset <= 0;
-        reg_cmd_in_progress <= 0;
-        reg_wea <= 0;
-        reg_web <= 0;
-        reg_clka <= 0;
-        //wire_clkb <= 0;
-        reg_dia <= 0;
-        reg_dib <= 0;
-        reg_cola <= 0;
-        reg_rowa <= 0;
-        //wire_colb <= 0;
-        //wire_rowb <= 0;
-        //reg_addrb <= 0;
+    assign wrapped_scan_column = adjusted_scan_column >= 336 ?
+        adjusted_scan_column - 336 : adjusted_scan_column;
+
+    assign display_col = wrapped_scan_column[9:0];
+    assign display_row = wrapped_scan_row[8:0];
+
+    // Port B slot selection (memory clock domain). The scan position only
+    // changes on the pixel clock, so it is steady in the display slot.
+    //
+    assign in_clip = (i_scan_column >= reg_clip_left) & (i_scan_column < reg_clip_right) &
+                     (i_scan_row >= reg_clip_top) & (i_scan_row < reg_clip_bottom);
+    assign display_slot = (i_pix_phase == DISPLAY_PHASE);
+    assign display_fetch = display_slot & in_clip & ~i_repeat_row & ~i_repeat_column;
+    assign display_replay = display_slot & in_clip & i_repeat_row & ~i_repeat_column;
+    assign display_clipped = display_slot & ~in_clip & ~i_repeat_column;
+    assign o_blit_grant = i_blit_stb & ~display_fetch;
+    assign wire_colb = display_fetch ? display_col : i_blit_col;
+    assign wire_rowb = display_fetch ? display_row : i_blit_row;
+    assign wire_web = o_blit_grant & i_blit_we;
+    assign wire_dib = i_blit_data;
+    assign wire_clkb = i_mem_clk;
+    assign o_blit_data = reg_dob;
+
+    always @(posedge i_mem_clk) begin
+        reg_display_fetched <= display_fetch;
+        reg_display_replayed <= display_replay;
+        reg_display_clipped <= display_clipped;
+        if (display_slot)
+            reg_line_column <= i_scan_column[8:0];
+        if (display_replay)
+            reg_line_data <= line_buffer[i_scan_column[8:0]];
+        if (reg_display_fetched) begin
+            reg_display_index <= reg_dob;
+            line_buffer[reg_line_column] <= reg_dob;
+        end else if (reg_display_replayed)
+            reg_display_index <= reg_line_data;
+        else if (reg_display_clipped)
+            reg_display_index <= reg_clip_index;
+        o_blit_valid <= o_blit_grant & ~i_blit_we;
+    end
+
+    assign o_color = wire_pal_dob;
+
+/*
+    Canvas commands:
+
+    The canvas has its own opcode (0000), with the command in bits 27:24,
+    so that none of its commands are taken by the text area as well. The
+    text area ignores opcode 0000. READ commands (1110) are shared, and are
+    told apart by their space. Scroll offsets are taken modulo the frame
+    buffer size: X (0 to 1023) modulo 336, and Y (0 to 511) modulo 256.
+
+    33222222222211111111110000000000
+    10987654321098765432109876543210
+    --------------------------------
+    00000001xxxxxxxxxxxxxxXXXXXXXXXX    Set horizontal scroll position (X offset)
+    00000010xxxxxxxxxxxxxxxYYYYYYYYY    Set vertical scroll position (Y offset)
+    00000011xxxYYYYYYYYYxxXXXXXXXXXX    Set horizontal and vertical scroll positions (X and Y offsets)
+    00000100xxxxIIIIIIIIRRRRGGGGBBBB    Set palette color for index (RGB)
+    00000101xxRRRRRRRRRRxxLLLLLLLLLL    Set clip left (L) and right (R) scan columns
+    00000110xxxBBBBBBBBBxxxTTTTTTTTT    Set clip top (T) and bottom (B) scan rows
+    00000111xxxxxxxxxxxxxxxxIIIIIIII    Set palette index shown outside the clip
+    11100011TTTTTTTTxxxxxxxxIIIIIIII    Read palette color for index (tag T)
+*/
+
+    // A palette write is set up on the command clock that handles the
+    // command, and is written into the palette on the following command
+    // clock (the one that ends the command). A palette read is likewise
+    // set up, and the palette is read on the clock that ends the command.
+    //
+    assign o_rd_data = {reg_rd_tag, 12'd0, wire_pal_doa};
+
+    always @(posedge i_rst or posedge i_cmd_clk) begin
+        if (i_rst) begin
+            reg_scroll_x_offset <= 0;
+            reg_scroll_y_offset <= 0;
+            reg_clip_left <= 0;
+            reg_clip_right <= 10'h3FF;
+            reg_clip_top <= 0;
+            reg_clip_bottom <= 9'h1FF;
+            reg_clip_index <= 0;
+            reg_cmd_in_progress <= 0;
+            reg_wea <= 0;
+            reg_clka <= 0;
+            reg_dia <= 0;
+            reg_cola <= 0;
+            reg_rowa <= 0;
+            reg_pal_wea <= 0;
+            reg_pal_addra <= 0;
+            reg_pal_dia <= 0;
+            reg_rd_pending <= 0;
+            reg_rd_tag <= 0;
+            o_rd_valid <= 0;
+        end else if (reg_cmd_in_progress) begin
+            reg_cmd_in_progress <= 0;
+            reg_pal_wea <= 0;
+            o_rd_valid <= reg_rd_pending;
+            reg_rd_pending <= 0;
+        end else begin
+            reg_cmd_in_progress <= 1;
+            o_rd_valid <= 0;
+            case (i_cmd_data[31:28])
+                4'b0000: begin
+                            case (i_cmd_data[27:24])
+                                4'b0001: reg_scroll_x_offset <= ring_column(i_cmd_data[9:0]);
+                                4'b0010: reg_scroll_y_offset <= {1'b0, i_cmd_data[7:0]};
+                                4'b0011: begin
+                                        reg_scroll_x_offset <= ring_column(i_cmd_data[9:0]);
+                                        reg_scroll_y_offset <= {1'b0, i_cmd_data[19:12]};
+                                    end
+                                4'b0100: begin
+                                        reg_pal_addra <= i_cmd_data[19:12];
+                                        reg_pal_dia <= i_cmd_data[11:0];
+                                        reg_pal_wea <= 1;
+                                    end
+                                4'b0101: begin
+                                        reg_clip_left <= i_cmd_data[9:0];
+                                        reg_clip_right <= i_cmd_data[21:12];
+                                    end
+                                4'b0110: begin
+                                        reg_clip_top <= i_cmd_data[8:0];
+                                        reg_clip_bottom <= i_cmd_data[20:12];
+                                    end
+                                4'b0111: reg_clip_index <= i_cmd_data[7:0];
+                            endcase
+                         end
+                4'b1110: begin
+                            if (i_cmd_data[27:24] == READ_SPACE) begin
+                                reg_pal_addra <= i_cmd_data[7:0];
+                                reg_rd_tag <= i_cmd_data[23:16];
+                                reg_rd_pending <= 1;
+                            end
+                         end
+            endcase
+        end
     end
 
 endmodule
@@ -5,6 +5,10 @@
  * and outputs the resulting color. The character pixel is based on the given
  * row and column within the character cell.
  *
+ * The glyph alpha is read on the clock after the inputs, so the colors
+ * should be given one clock after the character, row, and column. The
+ * output is valid 4 clocks after the character.
+ *
  * Copyright (C) 2024 Curtis Whitley
  * License: APACHE
  */
@@ -13,25 +17,36 @@
 
 module char_blender8x8 (
     input  wire i_clk,
+    input  wire i_gamma,
 	input  wire [7:0] i_char,
 	input  wire [2:0] i_row,
 	input  wire [2:0] i_column,
     input  wire [11:0] i_fg_color,
     input  wire [11:0] i_bg_color,
-	output wire [11:0] o_color
+	output wire [11:0] o_color,
+    input  wire i_glyph_clk,
+    input  wire i_glyph_we,
+    input  wire [13:0] i_glyph_addr,
+    input  wire [3:0] i_glyph_data
 );
 
-    wire [2:0] char_alpha;
+    wire [3:0] char_alpha;
 
     char_gen8x8 char_gen_inst (
         .i_clk(i_clk),
         .i_char(i_char),
         .i_row(i_row),
         .i_column(i_column),
-        .o_alpha(char_alpha)
+        .o_alpha(char_alpha),
+        .i_wr_clk(i_glyph_clk),
+        .i_wr_en(i_glyph_we),
+        .i_wr_addr(i_glyph_addr),
+        .i_wr_data(i_glyph_data)
     );
 
     color_blender blender (
+        .i_clk(i_clk),
+        .i_gamma(i_gamma),
         .i_bg_color(i_bg_color),
         .i_fg_color(i_fg_color),
         .i_fg_alpha(char_alpha),
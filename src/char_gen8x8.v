@@ -2,9 +2,12 @@
  * char_gen8x8.v
  *
  * This module looks up a character in the font table, and outputs a single pixel
- * for that character, in terms of its alpha code only, based on the given
+ * for that character, in terms of its 4-bit alpha code only, based on the given
  * row and column within the character cell.
  *
+ * The glyph table may be rewritten, one alpha code at a time, through the
+ * write port (i_wr_*), which has its own clock (see glyph_cache.v).
+ *
  * Copyright (C) 2024 Curtis Whitley
  * License: APACHE
  */
@@ -16,7 +19,11 @@ module char_gen8x8 (
 	input  wire [7:0] i_char,
 	input  wire [2:0] i_row,
 	input  wire [2:0] i_column,
-	output reg  [2:0] o_alpha
+	output reg  [3:0] o_alpha,
+	input  wire i_wr_clk,
+	input  wire i_wr_en,
+	input  wire [13:0] i_wr_addr,
+	input  wire [3:0] i_wr_data
 );
 
 	// The items in this array are arranged as if it were a 3D array:
@@ -26,16 +33,18 @@ module char_gen8x8 (
 	//
 	// Total number of alpha values is 256*8*8 = 16384.
 	//
-    reg [2:0] glyphs[0:16383];
-
-	wire [2:0] next_column;
-	assign next_column = (i_column == 0 ? 7 : i_column - 1);
+    reg [3:0] glyphs[0:16383];
 
     initial
         $readmemb("../font/font8x8.bits", glyphs, 0, 16383);
 
 	always @(posedge i_clk) begin
-		o_alpha <= glyphs[{i_char, i_row, next_column}];
+		o_alpha <= glyphs[{i_char, i_row, i_column}];
+	end
+
+	always @(posedge i_wr_clk) begin
+		if (i_wr_en)
+			glyphs[i_wr_addr] <= i_wr_data;
 	end
 
 endmodule
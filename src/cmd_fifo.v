@@ -0,0 +1,105 @@
+/*
+ * cmd_fifo.v
+ *
+ * This module is a dual-clock FIFO, used to carry commands (and other
+ * words) from one clock domain to another, such as from the 100 MHz engine
+ * domain to the 25 MHz pixel domain.
+ *
+ * The read and write pointers are passed between the domains as Gray
+ * codes, through two synchronizing registers each, so that only one bit
+ * changes at a time. The read side is first-word-fall-through: when
+ * o_empty is low, o_rd_data already holds the oldest word, and i_rd_en
+ * removes it.
+ *
+ * o_wr_empty is the write side's view of o_empty. It goes high 2 to 3
+ * write clocks after the last word is read, and never early, so the
+ * writer can tell when everything it wrote has been taken.
+ *
+ * A word written is seen on the read side 2 to 3 read clocks later.
+ * Both sides can move one word per clock.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module cmd_fifo #(
+        parameter WIDTH=32,
+        parameter ADDR_WIDTH=4
+    )(
+        input  wire i_rst,
+        input  wire i_wr_clk,
+        input  wire i_wr_en,
+        input  wire [WIDTH-1:0] i_wr_data,
+        output wire o_full,
+        output wire o_wr_empty,
+        input  wire i_rd_clk,
+        input  wire i_rd_en,
+        output wire [WIDTH-1:0] o_rd_data,
+        output wire o_empty
+    );
+
+    localparam DEPTH = (2**ADDR_WIDTH);
+
+    reg [WIDTH-1:0] words [0:DEPTH-1];
+
+    // Pointers have one extra bit, to tell full from empty.
+    reg [ADDR_WIDTH:0] wr_bin;
+    reg [ADDR_WIDTH:0] wr_gray;
+    reg [ADDR_WIDTH:0] rd_bin;
+    reg [ADDR_WIDTH:0] rd_gray;
+
+    // Each pointer, synchronized into the other domain.
+    reg [ADDR_WIDTH:0] rd_gray_w1;
+    reg [ADDR_WIDTH:0] rd_gray_w2;
+    reg [ADDR_WIDTH:0] wr_gray_r1;
+    reg [ADDR_WIDTH:0] wr_gray_r2;
+
+    wire [ADDR_WIDTH:0] wr_bin_next = wr_bin + {{ADDR_WIDTH{1'b0}}, (i_wr_en & ~o_full)};
+    wire [ADDR_WIDTH:0] wr_gray_next = (wr_bin_next >> 1) ^ wr_bin_next;
+    wire [ADDR_WIDTH:0] rd_bin_next = rd_bin + {{ADDR_WIDTH{1'b0}}, (i_rd_en & ~o_empty)};
+    wire [ADDR_WIDTH:0] rd_gray_next = (rd_bin_next >> 1) ^ rd_bin_next;
+
+    // Full when the write pointer has gone all the way around, past the
+    // read pointer: in Gray code, the top two bits differ and the rest match.
+    assign o_full = (wr_gray == {~rd_gray_w2[ADDR_WIDTH:ADDR_WIDTH-1],
+                                  rd_gray_w2[ADDR_WIDTH-2:0]});
+    assign o_wr_empty = (wr_gray == rd_gray_w2);
+    assign o_empty = (rd_gray == wr_gray_r2);
+    assign o_rd_data = words[rd_bin[ADDR_WIDTH-1:0]];
+
+    always @(posedge i_wr_clk) begin
+        if (i_wr_en & ~o_full)
+            words[wr_bin[ADDR_WIDTH-1:0]] <= i_wr_data;
+    end
+
+    always @(posedge i_rst or posedge i_wr_clk) begin
+        if (i_rst) begin
+            wr_bin <= 0;
+            wr_gray <= 0;
+            rd_gray_w1 <= 0;
+            rd_gray_w2 <= 0;
+        end else begin
+            wr_bin <= wr_bin_next;
+            wr_gray <= wr_gray_next;
+            rd_gray_w1 <= rd_gray;
+            rd_gray_w2 <= rd_gray_w1;
+        end
+    end
+
+    always @(posedge i_rst or posedge i_rd_clk) begin
+        if (i_rst) begin
+            rd_bin <= 0;
+            rd_gray <= 0;
+            wr_gray_r1 <= 0;
+            wr_gray_r2 <= 0;
+        end else begin
+            rd_bin <= rd_bin_next;
+            rd_gray <= rd_gray_next;
+            wr_gray_r1 <= wr_gray;
+            wr_gray_r2 <= wr_gray_r1;
+        end
+    end
+
+endmodule
@@ -0,0 +1,379 @@
+/*
+ * cmd_processor.v
+ *
+ * This module is the engine domain command processor. It gathers display
+ * commands from two sources, and writes them into the command FIFO that
+ * carries them to the pixel domain:
+ *
+ *  Direct commands: single 32-bit words written by the host, as before.
+ *
+ *  The command ring: a ring buffer of 32-bit commands in PSRAM. The host
+ *  writes a batch of commands into the ring (through its own PSRAM port),
+ *  then moves the ring head past them. The processor fetches commands from
+ *  the tail up to the head on its own, so the host can queue a whole frame
+ *  of work ahead of time, and then leave it alone.
+ *
+ * Each command in the ring takes two 16-bit PSRAM words, at consecutive
+ * addresses, with the upper half of the command first:
+ *
+ *  address = RING_BASE + 2 * index      command [31:16]
+ *  address = RING_BASE + 2 * index + 1  command [15:0]
+ *
+ * The ring holds 2^RING_SIZE commands, and the head and tail are command
+ * indexes into it, from 0 to 2^RING_SIZE-1. The ring is empty when the head
+ * equals the tail. The host must leave at least one free entry, so it may
+ * only move the head up to one entry before the tail (see o_ring_tail).
+ *
+ * Direct commands go first, whenever both sources have a command ready.
+ *
+ * Commands with opcode 1111 are engine commands. They are run by the
+ * processor itself, and are not passed on to the display modules:
+ *
+ *  31   27   23                       0
+ *  1111 0000 xxxxxxxxxxxxxxxxxxxxxxxx   NOP
+ *  1111 0001 AAAAAAAAAAAAAAAAAAAAAAAA   CALL the command list at A
+ *  1111 0010 xxxxxxxxxxxxxxxxxxxxxxxx   RETURN from a command list
+ *  1111 0011 xxxxxxxxxxxxxxxxxxxxxxxx   WAIT_VBLANK
+ *  1111 0100 xxxxxxxxxxxxxxLLLLLLLLLL   WAIT_LINE L
+ *  1111 0101 IIIIIIIIIIIIIIIIIIIIIIII   FENCE I
+ *
+ * A command list is a run of commands in PSRAM, stored like the ring
+ * entries (two words per command, upper half first), starting at PSRAM
+ * address A, and ending with RETURN. A CALL from the ring (or a direct
+ * CALL) runs the whole list before the next ring command, so a static
+ * sequence, such as a status bar redraw, is replayed with one command.
+ * Lists may CALL other lists, up to CALL_DEPTH levels; a CALL past that
+ * depth is skipped and sets o_call_overflow. A RETURN outside any list is
+ * ignored. A list without a RETURN never ends (until RING_BASE or
+ * RING_SIZE is written).
+ *
+ * WAIT_VBLANK holds back the commands after it until the scan reaches the
+ * first line of vertical blanking, and WAIT_LINE until the scan reaches
+ * line L (0 to 524), so that changes such as scrolling can be made
+ * between frames, or at a given line, without tearing. The next command
+ * is fetched during the wait, so it is passed on within a few clocks of
+ * the line starting.
+ *
+ * FENCE holds back the commands after it until every command before it
+ * has been run by the display modules (the command FIFO has drained), and
+ * then sets o_last_fence to I. The host can queue several frames of work,
+ * with a FENCE after each, and tell from o_last_fence when the buffers
+ * used by a frame may be reused. o_fence_done pulses for one clock as
+ * each fence completes, to post a completion event (see event_queue.v).
+ *
+ * Direct engine commands are taken only between fetches, and not during
+ * a wait (o_host_ready tells when). Direct display commands are passed on
+ * at once, even during a wait.
+ *
+ * Host register writes (i_reg_we, i_reg_addr, i_reg_data):
+ *
+ *  Addr Name      Bits  Meaning
+ *  ---- --------- ----- ----------------------------------------------
+ *   0   RING_BASE 23:0  PSRAM address of ring entry 0
+ *   1   RING_SIZE 4:0   Log2 of the ring length, in commands (max 22)
+ *   2   RING_HEAD 22:0  Index just past the last command written
+ *
+ * Host register reads (i_rd_addr, o_rd_data), for readback:
+ *
+ *  Addr Name        Bits  Meaning
+ *  ---- ----------- ----- ----------------------------------------------
+ *   0   RING_BASE   23:0  As written
+ *   1   RING_SIZE   4:0   As written
+ *   2   RING_HEAD   22:0  As written
+ *   3   RING_TAIL   22:0  Index of the next ring command to be fetched
+ *   4   LAST_FENCE  23:0  ID of the last FENCE completed
+ *   5   STATUS      5:0   {wait[1:0], call depth[2:0], call overflow}
+ *   6   FRAME_COUNT 31:0  Frames started (counted at vertical blanking)
+ *   7   SCAN_LINE   9:0   Scan line, as last seen in the engine domain
+ *
+ * Writing RING_BASE or RING_SIZE empties the ring (head = tail = 0), and
+ * abandons any command list being run, so they should only be written
+ * while the ring is empty (or to stop a runaway list).
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module cmd_processor #(
+        parameter CALL_DEPTH=4 // at most 7
+    )(
+    input  wire i_rst,
+    input  wire i_clk,
+    input  wire i_reg_we,
+    input  wire [3:0] i_reg_addr,
+    input  wire [31:0] i_reg_data,
+    input  wire [3:0] i_rd_addr,
+    output reg  [31:0] o_rd_data,
+    output wire [22:0] o_ring_tail,
+    output reg  o_call_overflow,
+    output reg  [23:0] o_last_fence,
+    output reg  o_fence_done,
+    output wire [31:0] o_frame_count,
+    output wire [9:0] o_scan_line,
+    input  wire [9:0] i_scan_line,
+    input  wire i_display_idle,
+    input  wire i_host_valid,
+    input  wire [31:0] i_host_data,
+    output wire o_host_ready,
+    output reg  o_mem_req,
+    output reg  [23:0] o_mem_addr,
+    input  wire i_mem_ack,
+    input  wire [15:0] i_mem_data,
+    output wire o_cmd_valid,
+    output wire [31:0] o_cmd_data,
+    input  wire i_cmd_full,
+    input  wire i_cmd_empty
+);
+
+    localparam REG_RING_BASE = 4'd0;
+    localparam REG_RING_SIZE = 4'd1;
+    localparam REG_RING_HEAD = 4'd2;
+    localparam REG_RING_TAIL = 4'd3;
+    localparam REG_LAST_FENCE = 4'd4;
+    localparam REG_STATUS = 4'd5;
+    localparam REG_FRAME_COUNT = 4'd6;
+    localparam REG_SCAN_LINE = 4'd7;
+
+    localparam OP_ENGINE = 4'b1111;
+    localparam ENG_NOP = 4'd0;
+    localparam ENG_CALL = 4'd1;
+    localparam ENG_RETURN = 4'd2;
+    localparam ENG_WAIT_VBLANK = 4'd3;
+    localparam ENG_WAIT_LINE = 4'd4;
+    localparam ENG_FENCE = 4'd5;
+
+    localparam VBLANK_LINE = 10'd480;
+
+    localparam WAIT_NONE = 2'd0;
+    localparam WAIT_LINE = 2'd1;
+    localparam WAIT_FENCE = 2'd2;
+
+    localparam FETCH_IDLE = 2'd0;
+    localparam FETCH_HIGH = 2'd1;
+    localparam FETCH_LOW = 2'd2;
+    localparam FETCH_ISSUE = 2'd3;
+
+    reg [23:0] reg_ring_base;
+    reg [4:0] reg_ring_size;
+    reg [22:0] reg_ring_head;
+    reg [22:0] reg_ring_tail;
+    reg [1:0] reg_fetch_state;
+    reg [31:0] reg_ring_cmd;
+
+    // The command list being run (when the call depth is not 0), and the
+    // return addresses of the lists that called it.
+    reg [23:0] reg_list_addr;
+    reg [2:0] reg_call_depth;
+    reg [23:0] call_stack [0:CALL_DEPTH-1];
+
+    // The wait in progress, if any.
+    reg [1:0] reg_wait;
+    reg [9:0] reg_wait_line;
+    reg [23:0] reg_pending_fence;
+
+    // The scan line and display idle flag, from the pixel domain. The line
+    // number changes once per line, so it is taken only when two samples
+    // in a row agree, and line_start is high for one clock when it changes.
+    reg [9:0] reg_line_s1;
+    reg [9:0] reg_line_s2;
+    reg [9:0] reg_line;
+    reg reg_idle_s1;
+    reg reg_idle_s2;
+    reg [31:0] reg_frame_count;
+    wire line_start = (reg_line_s1 == reg_line_s2) & (reg_line_s2 != reg_line);
+    wire waiting = (reg_wait != WAIT_NONE);
+
+    wire [22:0] ring_mask = ~(23'h7FFFFF << reg_ring_size);
+    wire fetch_idle = (reg_fetch_state == FETCH_IDLE) & ~i_reg_we;
+    wire in_list = (reg_call_depth != 0);
+
+    wire host_is_engine = (i_host_data[31:28] == OP_ENGINE);
+    wire host_display = i_host_valid & ~host_is_engine;
+    wire host_engine_taken = i_host_valid & host_is_engine & fetch_idle & ~waiting;
+
+    wire ring_cmd_ready = (reg_fetch_state == FETCH_ISSUE) & ~waiting;
+    wire ring_is_engine = (reg_ring_cmd[31:28] == OP_ENGINE);
+    wire ring_engine_taken = ring_cmd_ready & ring_is_engine;
+    wire ring_display_taken = ring_cmd_ready & ~ring_is_engine & ~host_display & ~i_cmd_full;
+
+    wire engine_taken = host_engine_taken | ring_engine_taken;
+    wire [31:0] engine_cmd = host_engine_taken ? i_host_data : reg_ring_cmd;
+
+    // A CALL from a list returns to the command after it. A direct CALL
+    // returns to the next command that the list (if any) would have run.
+    wire [23:0] return_addr = host_engine_taken ? reg_list_addr : (reg_list_addr + 2);
+
+    assign o_ring_tail = reg_ring_tail;
+    assign o_frame_count = reg_frame_count;
+    assign o_scan_line = reg_line;
+
+    always @(*) begin
+        case (i_rd_addr)
+            REG_RING_BASE: o_rd_data = {8'd0, reg_ring_base};
+            REG_RING_SIZE: o_rd_data = {27'd0, reg_ring_size};
+            REG_RING_HEAD: o_rd_data = {9'd0, reg_ring_head};
+            REG_RING_TAIL: o_rd_data = {9'd0, reg_ring_tail};
+            REG_LAST_FENCE: o_rd_data = {8'd0, o_last_fence};
+            REG_STATUS: o_rd_data = {26'd0, reg_wait, reg_call_depth, o_call_overflow};
+            REG_FRAME_COUNT: o_rd_data = reg_frame_count;
+            REG_SCAN_LINE: o_rd_data = {22'd0, reg_line};
+            default: o_rd_data = 32'd0;
+        endcase
+    end
+    assign o_host_ready = host_is_engine ? (fetch_idle & ~waiting) : ~i_cmd_full;
+    assign o_cmd_valid = host_display | (ring_cmd_ready & ~ring_is_engine);
+    assign o_cmd_data = host_display ? i_host_data : reg_ring_cmd;
+
+    always @(posedge i_clk) begin
+        if (engine_taken & (engine_cmd[27:24] == ENG_CALL) & (reg_call_depth < CALL_DEPTH))
+            call_stack[reg_call_depth] <= return_addr;
+    end
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_ring_base <= 0;
+            reg_ring_size <= 0;
+            reg_ring_head <= 0;
+            reg_ring_tail <= 0;
+            reg_fetch_state <= FETCH_IDLE;
+            reg_ring_cmd <= 0;
+            reg_list_addr <= 0;
+            reg_call_depth <= 0;
+            o_call_overflow <= 0;
+            o_last_fence <= 0;
+            o_fence_done <= 0;
+            reg_wait <= WAIT_NONE;
+            reg_wait_line <= 0;
+            reg_pending_fence <= 0;
+            reg_line_s1 <= 0;
+            reg_line_s2 <= 0;
+            reg_line <= 0;
+            reg_idle_s1 <= 0;
+            reg_idle_s2 <= 0;
+            reg_frame_count <= 0;
+            o_mem_req <= 0;
+            o_mem_addr <= 0;
+        end else begin
+            reg_line_s1 <= i_scan_line;
+            reg_line_s2 <= reg_line_s1;
+            if (line_start)
+                reg_line <= reg_line_s2;
+            if (line_start & (reg_line_s2 == VBLANK_LINE))
+                reg_frame_count <= reg_frame_count + 1;
+            reg_idle_s1 <= i_display_idle;
+            reg_idle_s2 <= reg_idle_s1;
+            o_fence_done <= 0;
+
+            case (reg_wait)
+                WAIT_LINE: begin
+                        if (line_start & (reg_line_s2 == reg_wait_line))
+                            reg_wait <= WAIT_NONE;
+                    end
+                WAIT_FENCE: begin
+                        if (i_cmd_empty & reg_idle_s2) begin
+                            o_last_fence <= reg_pending_fence;
+                            o_fence_done <= 1;
+                            reg_wait <= WAIT_NONE;
+                        end
+                    end
+            endcase
+
+            case (reg_fetch_state)
+                FETCH_IDLE: begin
+                        if (~i_reg_we & ~host_engine_taken) begin
+                            if (in_list) begin
+                                o_mem_req <= 1;
+                                o_mem_addr <= reg_list_addr;
+                                reg_fetch_state <= FETCH_HIGH;
+                            end else if (reg_ring_head != reg_ring_tail) begin
+                                o_mem_req <= 1;
+                                o_mem_addr <= reg_ring_base + {reg_ring_tail, 1'b0};
+                                reg_fetch_state <= FETCH_HIGH;
+                            end
+                        end
+                    end
+                FETCH_HIGH: begin
+                        if (i_mem_ack) begin
+                            reg_ring_cmd[31:16] <= i_mem_data;
+                            o_mem_addr <= o_mem_addr + 1;
+                            reg_fetch_state <= FETCH_LOW;
+                        end
+                    end
+                FETCH_LOW: begin
+                        if (i_mem_ack) begin
+                            o_mem_req <= 0;
+                            reg_ring_cmd[15:0] <= i_mem_data;
+                            reg_fetch_state <= FETCH_ISSUE;
+                        end
+                    end
+                default: begin
+                        if (ring_engine_taken | ring_display_taken) begin
+                            if (in_list)
+                                reg_list_addr <= reg_list_addr + 2;
+                            else
+                                reg_ring_tail <= (reg_ring_tail + 1) & ring_mask;
+                            reg_fetch_state <= FETCH_IDLE;
+                        end
+                    end
+            endcase
+
+            // Engine commands (these override the list address set above).
+            if (engine_taken) begin
+                case (engine_cmd[27:24])
+                    ENG_CALL: begin
+                            if (reg_call_depth < CALL_DEPTH) begin
+                                reg_list_addr <= engine_cmd[23:0];
+                                reg_call_depth <= reg_call_depth + 1;
+                            end else
+                                o_call_overflow <= 1;
+                        end
+                    ENG_RETURN: begin
+                            if (in_list) begin
+                                reg_list_addr <= call_stack[reg_call_depth - 1];
+                                reg_call_depth <= reg_call_depth - 1;
+                            end
+                        end
+                    ENG_WAIT_VBLANK: begin
+                            reg_wait_line <= VBLANK_LINE;
+                            reg_wait <= WAIT_LINE;
+                        end
+                    ENG_WAIT_LINE: begin
+                            reg_wait_line <= engine_cmd[9:0];
+                            reg_wait <= WAIT_LINE;
+                        end
+                    ENG_FENCE: begin
+                            reg_pending_fence <= engine_cmd[23:0];
+                            reg_wait <= WAIT_FENCE;
+                        end
+                endcase
+            end
+
+            if (i_reg_we) begin
+                case (i_reg_addr)
+                    REG_RING_BASE: begin
+                            reg_ring_base <= i_reg_data[23:0];
+                            reg_ring_head <= 0;
+                            reg_ring_tail <= 0;
+                            reg_call_depth <= 0;
+                            reg_wait <= WAIT_NONE;
+                            o_call_overflow <= 0;
+                        end
+                    REG_RING_SIZE: begin
+                            reg_ring_size <= i_reg_data[4:0];
+                            reg_ring_head <= 0;
+                            reg_ring_tail <= 0;
+                            reg_call_depth <= 0;
+                            reg_wait <= WAIT_NONE;
+                            o_call_overflow <= 0;
+                        end
+                    REG_RING_HEAD: begin
+                            reg_ring_head <= i_reg_data[22:0] & ring_mask;
+                        end
+                endcase
+            end
+        end
+    end
+
+endmodule
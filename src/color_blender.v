@@ -3,7 +3,10 @@
  *
  * This module blends the individual color components (red, green, and blue)
  * of a background color and a foreground color, using the given alpha code,
- * and outputs the resulting color.
+ * and outputs the resulting color. The blend is either done linearly on the
+ * gamma-encoded components (i_gamma = 0), or on linear light (i_gamma = 1).
+ *
+ * The output is valid 3 clocks after the inputs, in both modes.
  *
  * Copyright (C) 2024 Curtis Whitley
  * License: APACHE
@@ -12,27 +15,35 @@
 `default_nettype none
 
 module color_blender (
+	input wire i_clk,
+	input wire i_gamma,
 	input wire [11:0] i_bg_color,
 	input wire [11:0] i_fg_color,
-	input wire [2:0] i_fg_alpha,
+	input wire [3:0] i_fg_alpha,
 	output logic [11:0] o_color
 );
 
-component_blender blend_r (
+gamma_blender blend_r (
+	.i_clk(i_clk),
+	.i_gamma(i_gamma),
 	.i_bg_color(i_bg_color[11:8]),
 	.i_fg_color(i_fg_color[11:8]),
 	.i_fg_alpha(i_fg_alpha),
 	.o_color(o_color[11:8])
 );
 
-component_blender blend_g (
+gamma_blender blend_g (
+	.i_clk(i_clk),
+	.i_gamma(i_gamma),
 	.i_bg_color(i_bg_color[7:4]),
 	.i_fg_color(i_fg_color[7:4]),
 	.i_fg_alpha(i_fg_alpha),
 	.o_color(o_color[7:4])
 );
 
-component_blender blend_b (
+gamma_blender blend_b (
+	.i_clk(i_clk),
+	.i_gamma(i_gamma),
 	.i_bg_color(i_bg_color[3:0]),
 	.i_fg_color(i_fg_color[3:0]),
 	.i_fg_alpha(i_fg_alpha),
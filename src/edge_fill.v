@@ -0,0 +1,173 @@
+/*
+ * edge_fill.v
+ *
+ * This module tells the host which text ring cells may be refilled while
+ * the text area scrolls, in the engine domain. The text array in
+ * text_area8x8.v is a ring of 84x64 cells, of which at most 81x61 are
+ * visible at once (80x60, plus one partly shown on each axis), so the
+ * other cells can be filled with new text while scrolling, before they
+ * come into view.
+ *
+ * The module watches the display commands as they enter the command FIFO,
+ * and follows the scroll position of text window 0 set by them (commands
+ * 0001, 0010, 0011, and the window 0 scroll command 11010010), as the text
+ * area will. The ring column shown at the left edge, and the ring row
+ * shown at the top edge, follow the scroll position one cell at a time.
+ * Each time the left column moves by one, a column event is posted, with
+ * the ring column that has just gone out of view; each time the top row
+ * moves by one, a row event is posted, with the ring row that has just
+ * gone out of view. The host (woken by the event interrupt, see
+ * event_queue.v) fills that column or row with the text that comes into
+ * view next, on the far side. Cell writes given after the event follow the
+ * scroll command down the command FIFO, so they never land on a visible
+ * cell.
+ *
+ * Event tags:
+ *
+ *  Bits  Meaning
+ *  ----- -----------------------------------------------------------
+ *   8    0 = scrolled right (column) or down (row), 1 = left or up
+ *   6:0  Ring column (0 to 83), or ring row (0 to 63), now hidden
+ *
+ * The edges move by at most one cell every EVENT_GAP clocks, so a scroll
+ * of many cells at once posts many events, and may overflow the event
+ * FIFO; the host can then read the status registers to catch up.
+ *
+ * Host register reads (i_rd_addr, o_rd_data), for readback space 5:
+ *
+ *  Addr Name        Bits   Meaning
+ *  ---- ----------- ------ ----------------------------------------------
+ *   0   EDGE        21:16  Ring row at the top edge
+ *                   6:0    Ring column at the left edge
+ *   1   NEXT_COLUMN 22:16  Next ring column to fill, when scrolling left
+ *                   6:0    Next ring column to fill, when scrolling right
+ *   2   NEXT_ROW    21:16  Next ring row to fill, when scrolling up
+ *                   5:0    Next ring row to fill, when scrolling down
+ *   3   SCROLL      24:16  Text scroll Y offset
+ *                   9:0    Text scroll X offset
+ *
+ * The next column or row to fill is the hidden one that comes into view
+ * first, if the text scrolls one more cell that way.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module edge_fill #(
+        parameter EVENT_GAP=3
+    )(
+        input  wire i_rst,
+        input  wire i_clk,
+        input  wire i_cmd_valid,
+        input  wire [31:0] i_cmd_data,
+        input  wire [1:0] i_rd_addr,
+        output reg  [31:0] o_rd_data,
+        output reg  o_column_event,
+        output reg  [23:0] o_column_tag,
+        output reg  o_row_event,
+        output reg  [23:0] o_row_tag
+    );
+
+    localparam COLUMNS = 84;
+    localparam ROWS = 64;
+    localparam VISIBLE_COLUMNS = 81;
+    localparam [5:0] VISIBLE_ROWS = 6'd61;
+
+    reg [9:0] reg_scroll_x;
+    reg [8:0] reg_scroll_y;
+    reg [6:0] reg_left;
+    reg [5:0] reg_top;
+    reg [2:0] reg_gap;
+
+    // The ring column and row that the scroll position puts at the edges.
+    wire [9:0] wrapped_x = (reg_scroll_x >= COLUMNS * 8) ?
+                           (reg_scroll_x - COLUMNS * 8) : reg_scroll_x;
+    wire [6:0] target_left = wrapped_x[9:3];
+    wire [5:0] target_top = reg_scroll_y[8:3];
+
+    // Which way to move each edge: the shorter way around the ring.
+    wire [6:0] column_ahead = (target_left >= reg_left) ?
+                              (target_left - reg_left) : (target_left + COLUMNS - reg_left);
+    wire [5:0] row_ahead = target_top - reg_top;
+    wire column_right = (column_ahead <= COLUMNS / 2);
+    wire row_down = (row_ahead <= ROWS / 2);
+
+    wire [6:0] left_next = (reg_left == COLUMNS - 1) ? 7'd0 : reg_left + 1;
+    wire [6:0] left_prev = (reg_left == 0) ? (COLUMNS - 1) : reg_left - 1;
+    wire [7:0] right_sum = reg_left + VISIBLE_COLUMNS;
+    wire [6:0] fill_right = (right_sum >= COLUMNS) ? (right_sum - COLUMNS) : right_sum[6:0];
+    wire [7:0] hidden_sum = reg_left + VISIBLE_COLUMNS - 1;
+    wire [6:0] hidden_right = (hidden_sum >= COLUMNS) ? (hidden_sum - COLUMNS) : hidden_sum[6:0];
+
+    always @(*) begin
+        case (i_rd_addr)
+            2'd0: o_rd_data = {10'd0, reg_top, 9'd0, reg_left};
+            2'd1: o_rd_data = {9'd0, left_prev, 9'd0, fill_right};
+            2'd2: o_rd_data = {10'd0, reg_top - 6'd1, 10'd0, reg_top + VISIBLE_ROWS};
+            default: o_rd_data = {7'd0, reg_scroll_y, 6'd0, reg_scroll_x};
+        endcase
+    end
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_scroll_x <= 0;
+            reg_scroll_y <= 0;
+            reg_left <= 0;
+            reg_top <= 0;
+            reg_gap <= 0;
+            o_column_event <= 0;
+            o_column_tag <= 0;
+            o_row_event <= 0;
+            o_row_tag <= 0;
+        end else begin
+            o_column_event <= 0;
+            o_row_event <= 0;
+
+            if (i_cmd_valid) begin
+                case (i_cmd_data[31:28])
+                    4'b0001: reg_scroll_x <= i_cmd_data[9:0];
+                    4'b0010: reg_scroll_y <= i_cmd_data[8:0];
+                    4'b0011: begin
+                                reg_scroll_x <= i_cmd_data[9:0];
+                                reg_scroll_y <= i_cmd_data[24:16];
+                             end
+                    4'b1101: begin
+                                if (i_cmd_data[27:24] == 4'b0010) begin
+                                    reg_scroll_x <= i_cmd_data[9:0];
+                                    reg_scroll_y <= i_cmd_data[20:12];
+                                end
+                             end
+                endcase
+            end
+
+            if (reg_gap != 0)
+                reg_gap <= reg_gap - 1;
+            else if (target_left != reg_left) begin
+                // Moving right hides the old left column; moving left hides
+                // the column just past the new right edge.
+                o_column_event <= 1;
+                reg_gap <= EVENT_GAP - 1;
+                if (column_right) begin
+                    o_column_tag <= {15'd0, 1'b0, 1'b0, reg_left};
+                    reg_left <= left_next;
+                end else begin
+                    o_column_tag <= {15'd0, 1'b1, 1'b0, hidden_right};
+                    reg_left <= left_prev;
+                end
+            end else if (target_top != reg_top) begin
+                o_row_event <= 1;
+                reg_gap <= EVENT_GAP - 1;
+                if (row_down) begin
+                    o_row_tag <= {15'd0, 1'b0, 2'd0, reg_top};
+                    reg_top <= reg_top + 1;
+                end else begin
+                    o_row_tag <= {15'd0, 1'b1, 2'd0, reg_top + VISIBLE_ROWS - 6'd1};
+                    reg_top <= reg_top - 1;
+                end
+            end
+        end
+    end
+
+endmodule
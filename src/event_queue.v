@@ -0,0 +1,132 @@
+/*
+ * event_queue.v
+ *
+ * This module records completion events from engine operations (such as
+ * FENCE completion, text ring edge changes, and later blits) in a FIFO, so the host
+ * does not need to poll busy bits. o_irq is high while the FIFO holds any
+ * event, so the host may sleep (or do other work) until it goes high.
+ *
+ * Each source pulses its i_event bit for one clock, with a 24-bit tag on
+ * its part of i_event_tag (source 0 in the low bits). The event is then
+ * stored with its type (the source number plus 1) and the frame and scan
+ * line at which it happened. Sources that post on the same clock are
+ * stored one per clock, in source order; a source should not post again
+ * until its last event has been stored (which takes at most SOURCES
+ * clocks).
+ *
+ * The host reads events through readback space 1 (see readback.v):
+ *
+ *  Addr Data
+ *  ---- ------------------------------------------------------------
+ *   0   Oldest event: {type[3:0], 4'b0, tag[23:0]} (type 0: none)
+ *   1   Oldest event: {frame[15:0], 6'b0, line[9:0]}, and remove it
+ *   2   {overflow, 0..., count} (count is ADDR_WIDTH+1 bits)
+ *
+ * If an event arrives while the FIFO is full, it is dropped, and the
+ * overflow flag is set until the FIFO is next emptied.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module event_queue #(
+        parameter SOURCES=1,
+        parameter ADDR_WIDTH=4
+    )(
+        input  wire i_rst,
+        input  wire i_clk,
+        input  wire [SOURCES-1:0] i_event,
+        input  wire [SOURCES*24-1:0] i_event_tag,
+        input  wire [31:0] i_frame_count,
+        input  wire [9:0] i_scan_line,
+        input  wire [1:0] i_rd_addr,
+        input  wire i_rd_en,
+        output reg  [31:0] o_rd_data,
+        output wire o_irq
+    );
+
+    localparam DEPTH = (2**ADDR_WIDTH);
+
+    // Each entry: {type[3:0], tag[23:0], frame[15:0], line[9:0]}
+    reg [53:0] events [0:DEPTH-1];
+    reg [ADDR_WIDTH:0] reg_wr_ptr;
+    reg [ADDR_WIDTH:0] reg_rd_ptr;
+    reg reg_overflow;
+
+    // Events not yet stored, one per source.
+    reg [SOURCES-1:0] reg_pending;
+    reg [SOURCES*24-1:0] reg_pending_tag;
+
+    wire [ADDR_WIDTH:0] count = reg_wr_ptr - reg_rd_ptr;
+    wire empty = (count == 0);
+    wire full = (count == DEPTH);
+    wire [53:0] oldest = events[reg_rd_ptr[ADDR_WIDTH-1:0]];
+    wire pop = i_rd_en & (i_rd_addr == 2'd1) & ~empty;
+
+    // The lowest numbered source with an event to store.
+    reg [3:0] pick;
+    reg found;
+    integer i;
+
+    always @(*) begin
+        found = 0;
+        pick = 0;
+        for (i = 0; i < SOURCES; i = i + 1) begin
+            if (~found & reg_pending[i]) begin
+                found = 1;
+                pick = i;
+            end
+        end
+    end
+
+    always @(*) begin
+        case (i_rd_addr)
+            2'd0: o_rd_data = empty ? 32'd0 : {oldest[53:50], 4'd0, oldest[49:26]};
+            2'd1: o_rd_data = empty ? 32'd0 : {oldest[25:10], 6'd0, oldest[9:0]};
+            default: o_rd_data = {reg_overflow, {(30-ADDR_WIDTH){1'b0}}, count};
+        endcase
+    end
+
+    assign o_irq = ~empty;
+
+    always @(posedge i_clk) begin
+        if (found & ~full)
+            events[reg_wr_ptr[ADDR_WIDTH-1:0]] <=
+                {pick + 4'd1, reg_pending_tag[pick*24 +: 24],
+                 i_frame_count[15:0], i_scan_line};
+    end
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_wr_ptr <= 0;
+            reg_rd_ptr <= 0;
+            reg_overflow <= 0;
+            reg_pending <= 0;
+            reg_pending_tag <= 0;
+        end else begin
+            if (found) begin
+                reg_pending[pick] <= 0;
+                if (full)
+                    reg_overflow <= 1;
+                else
+                    reg_wr_ptr <= reg_wr_ptr + 1;
+            end
+
+            for (i = 0; i < SOURCES; i = i + 1) begin
+                if (i_event[i]) begin
+                    reg_pending[i] <= 1;
+                    reg_pending_tag[i*24 +: 24] <= i_event_tag[i*24 +: 24];
+                end
+            end
+
+            if (pop) begin
+                reg_rd_ptr <= reg_rd_ptr + 1;
+                if (count == 1)
+                    reg_overflow <= 0;
+            end
+        end
+    end
+
+endmodule
@@ -10,7 +10,14 @@
  *
  * The column index ranges from 0 to 335, taking 9 bits.
  * The row index ranges from 0 to 255, taking 8 bits.
- * Thus, the total address space is 17 bits.
+ *
+ * The cells are stored column by column, so the address of a cell
+ * is col*256+row, which is simply {col,row}. Because there are exactly
+ * 256 rows, this mapping is dense: addresses run from 0 to 86015 with
+ * no gaps, and no shifts or adds are needed in the pixel path. The
+ * memory is declared with exactly 86016 entries, so that synthesis
+ * does not reserve BRAM for the unused top of the 17-bit address
+ * space (131072 entries).
  *
  * Since the size of the frame buffer in cells is 336x256, it has a
  * margin of 8 cells around a screen size of 320x240 (i.e.,
@@ -46,21 +53,28 @@ module frame_buffer(
         output reg [7:0] dob          // data out B
     );
 
-    reg [7:0] cells [0:335][0:255];
+    localparam COLUMNS = 336;
+    localparam ROWS = 256;
+    localparam DEPTH = COLUMNS * ROWS; // 86016
+
+    reg [7:0] cells [0:DEPTH-1];
+
+    wire [16:0] addra = {cola, rowa};
+    wire [16:0] addrb = {colb, rowb};
 
     initial $readmemh("../image/car336x256x256.bits", cells);
 
     always @(posedge clka) begin
         if (wea) begin
-            cells[{cola,rowa}] <= dia;
+            cells[addra] <= dia;
         end else
-            doa <= cells[{cola,rowa}];
+            doa <= cells[addra];
     end
 
     always @(posedge clkb) begin
         if (web) begin
-            cells[{colb,rowb}] <= dib;
+            cells[addrb] <= dib;
         end else
-            dob <= cells[{colb,rowb}];
+            dob <= cells[addrb];
     end
 endmodule
@@ -0,0 +1,240 @@
+/*
+ * frame_crc.v
+ *
+ * This module computes a signature of each frame as it is shown: a CRC32
+ * over the color of every active pixel (o_r, o_g, o_b) inside a region of
+ * the screen, so regression scenes can be checked on the board itself,
+ * once per frame, against the CRCs that the host model computes
+ * (model/frame_crc.c), without a camera or capture card.
+ *
+ * The CRC is the usual CRC32 (polynomial 04C11DB7, bit reflected, start
+ * FFFFFFFF, final complement). Each pixel in the region, left to right and
+ * top to bottom, adds its 12-bit color {R, G, B}, lowest bit first. Pixels
+ * outside the active area are not included.
+ *
+ * The display layers give a pixel's color LATENCY pixel clocks after its
+ * scan position, so i_color and i_active are taken as being for the scan
+ * position given LATENCY clocks before, and the region test and the end of
+ * the frame are delayed to meet them.
+ *
+ * The CRC is computed in the pixel domain, and finished as the vertical
+ * blank starts. It is then carried to the engine domain (by a toggle,
+ * synchronized there), along with a count of frames checked, so the host
+ * can tell when a new CRC has arrived.
+ *
+ * The region is set in the engine domain. After a write, it is copied to
+ * a holding register, and a request toggle is sent to the pixel domain,
+ * which takes the held region at the next frame end, and toggles an
+ * acknowledge back. Writes made while a request is in flight are sent with
+ * the next request, so the last region written always takes effect, one
+ * or two frames later.
+ *
+ * Host register writes (i_reg_we, i_reg_addr, i_reg_data):
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   COLUMNS    21:12  Right; pixels from left up to right
+ *                  9:0    Left
+ *   1   ROWS       20:12  Bottom; pixels from top up to bottom
+ *                  8:0    Top
+ *
+ * Host register reads (i_rd_addr, o_rd_data), for readback space 8:
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   CRC        31:0   CRC of the last whole frame
+ *   1   FRAMES     31:0   Frames checked
+ *   2   COLUMNS    21:12  Region right
+ *                  9:0    Region left
+ *   3   ROWS       20:12  Region bottom
+ *                  8:0    Region top
+ *
+ * At reset, the region is the whole screen.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module frame_crc #(
+        parameter HEIGHT=480,
+        parameter LATENCY=1
+    )(
+        input  wire i_rst,
+        input  wire i_clk,
+        input  wire i_reg_we,
+        input  wire i_reg_addr,
+        input  wire [31:0] i_reg_data,
+        input  wire [1:0] i_rd_addr,
+        output reg  [31:0] o_rd_data,
+        input  wire i_pix_clk,
+        input  wire i_active,
+        input  wire [8:0] i_scan_row,
+        input  wire [9:0] i_scan_column,
+        input  wire [11:0] i_color
+    );
+
+    localparam REG_COLUMNS = 1'b0;
+    localparam REG_ROWS = 1'b1;
+
+    function [31:0] crc_add;
+        input [31:0] crc;
+        input [11:0] color;
+        integer b;
+        begin
+            crc_add = crc;
+            for (b = 0; b < 12; b = b + 1) begin
+                if (crc_add[0] ^ color[b])
+                    crc_add = (crc_add >> 1) ^ 32'hEDB88320;
+                else
+                    crc_add = crc_add >> 1;
+            end
+        end
+    endfunction
+
+    // Engine domain: the region, and the last CRC carried over.
+    reg [9:0] reg_left;
+    reg [9:0] reg_right;
+    reg [8:0] reg_top;
+    reg [8:0] reg_bottom;
+    reg reg_region_pending;
+    reg reg_region_req;
+    reg [1:0] reg_region_ack_sync;
+    reg [9:0] reg_send_left;
+    reg [9:0] reg_send_right;
+    reg [8:0] reg_send_top;
+    reg [8:0] reg_send_bottom;
+    reg [2:0] reg_done_sync;
+    reg [31:0] reg_crc;
+    reg [31:0] reg_frames;
+
+    // Pixel domain: the region in use, the CRC being computed, and the
+    // last one finished.
+    reg [9:0] reg_pix_left;
+    reg [9:0] reg_pix_right;
+    reg [8:0] reg_pix_top;
+    reg [8:0] reg_pix_bottom;
+    reg [1:0] reg_region_sync;
+    reg reg_region_seen;
+    reg [31:0] reg_pix_crc;
+    reg [31:0] reg_pix_done_crc;
+    reg [31:0] reg_pix_frames;
+    reg reg_done_toggle;
+
+    // The region test and the end of the frame, for each scan position,
+    // delayed to meet that position's color.
+    reg [LATENCY-1:0] reg_region_pipe;
+    reg [LATENCY-1:0] reg_end_pipe;
+    integer d;
+
+    wire scan_in_region = (i_scan_column >= reg_pix_left) & (i_scan_column < reg_pix_right) &
+                          (i_scan_row >= reg_pix_top) & (i_scan_row < reg_pix_bottom);
+    wire scan_end = (i_scan_row == HEIGHT) & (i_scan_column == 0);
+    wire in_region = i_active & reg_region_pipe[LATENCY-1];
+    wire frame_end = reg_end_pipe[LATENCY-1];
+
+    always @(posedge i_pix_clk) begin
+        reg_region_pipe[0] <= scan_in_region;
+        reg_end_pipe[0] <= scan_end;
+        for (d = 1; d < LATENCY; d = d + 1) begin
+            reg_region_pipe[d] <= reg_region_pipe[d-1];
+            reg_end_pipe[d] <= reg_end_pipe[d-1];
+        end
+    end
+
+    always @(*) begin
+        case (i_rd_addr)
+            2'd0: o_rd_data = reg_crc;
+            2'd1: o_rd_data = reg_frames;
+            2'd2: o_rd_data = {10'd0, reg_right, 2'd0, reg_left};
+            default: o_rd_data = {11'd0, reg_bottom, 3'd0, reg_top};
+        endcase
+    end
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_left <= 0;
+            reg_right <= 10'h3FF;
+            reg_top <= 0;
+            reg_bottom <= 9'h1FF;
+            reg_region_pending <= 0;
+            reg_region_req <= 0;
+            reg_region_ack_sync <= 0;
+            reg_send_left <= 0;
+            reg_send_right <= 10'h3FF;
+            reg_send_top <= 0;
+            reg_send_bottom <= 9'h1FF;
+            reg_done_sync <= 0;
+            reg_crc <= 0;
+            reg_frames <= 0;
+        end else begin
+            // The held region stays put from the request until the
+            // acknowledge comes back.
+            reg_region_ack_sync <= {reg_region_ack_sync[0], reg_region_seen};
+            if (reg_region_pending & (reg_region_req == reg_region_ack_sync[1])) begin
+                reg_send_left <= reg_left;
+                reg_send_right <= reg_right;
+                reg_send_top <= reg_top;
+                reg_send_bottom <= reg_bottom;
+                reg_region_req <= ~reg_region_req;
+                reg_region_pending <= 0;
+            end
+
+            if (i_reg_we) begin
+                case (i_reg_addr)
+                    REG_COLUMNS: begin
+                            reg_left <= i_reg_data[9:0];
+                            reg_right <= i_reg_data[21:12];
+                        end
+                    REG_ROWS: begin
+                            reg_top <= i_reg_data[8:0];
+                            reg_bottom <= i_reg_data[20:12];
+                        end
+                endcase
+                reg_region_pending <= 1;
+            end
+
+            // The finished CRC is held for a whole frame after the toggle.
+            reg_done_sync <= {reg_done_sync[1:0], reg_done_toggle};
+            if (reg_done_sync[2] != reg_done_sync[1]) begin
+                reg_crc <= reg_pix_done_crc;
+                reg_frames <= reg_pix_frames;
+            end
+        end
+    end
+
+    always @(posedge i_rst or posedge i_pix_clk) begin
+        if (i_rst) begin
+            reg_pix_left <= 0;
+            reg_pix_right <= 10'h3FF;
+            reg_pix_top <= 0;
+            reg_pix_bottom <= 9'h1FF;
+            reg_region_sync <= 0;
+            reg_region_seen <= 0;
+            reg_pix_crc <= 32'hFFFFFFFF;
+            reg_pix_done_crc <= 0;
+            reg_pix_frames <= 0;
+            reg_done_toggle <= 0;
+        end else begin
+            reg_region_sync <= {reg_region_sync[0], reg_region_req};
+
+            if (frame_end) begin
+                reg_pix_done_crc <= ~reg_pix_crc;
+                reg_pix_frames <= reg_pix_frames + 1;
+                reg_done_toggle <= ~reg_done_toggle;
+                reg_pix_crc <= 32'hFFFFFFFF;
+                if (reg_region_sync[1] != reg_region_seen) begin
+                    // The held region was set at least two clocks ago.
+                    reg_region_seen <= reg_region_sync[1];
+                    reg_pix_left <= reg_send_left;
+                    reg_pix_right <= reg_send_right;
+                    reg_pix_top <= reg_send_top;
+                    reg_pix_bottom <= reg_send_bottom;
+                end
+            end else if (in_region)
+                reg_pix_crc <= crc_add(reg_pix_crc, i_color);
+        end
+    end
+
+endmodule
@@ -0,0 +1,123 @@
+/*
+ * gamma_blender.v
+ *
+ * This module blends a single 4-bit color component of a foreground color
+ * over the same component of a background color, using a 4-bit linear alpha
+ * code, in one of two modes:
+ *
+ *  Linear mode (i_gamma = 0): the gamma-encoded components are blended
+ *  directly, exactly as done by component_blender.
+ *
+ *  Gamma-correct mode (i_gamma = 1): both components are first converted to
+ *  8-bit linear light (gamma 2.2), blended there, and converted back to the
+ *  nearest 4-bit component. This avoids the dark fringes that appear around
+ *  anti-aliased text when blending gamma-encoded values.
+ *
+ * The module is pipelined, and accepts a new pixel on every clock. The output
+ * is valid BLEND_LATENCY (3) clocks after the inputs, in both modes, so that
+ * switching modes never shifts the image.
+ *
+ *  Stage 1: linearize the components (16-entry table), and do the linear blend.
+ *  Stage 2: blend the linear light values, as round(sum / 15).
+ *  Stage 3: delinearize (15 threshold comparisons), and select the mode.
+ *
+ * The tables and thresholds come from model/blend_model.c, which computes
+ * the same results on the host, bit for bit.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module gamma_blender (
+	input wire i_clk,
+	input wire i_gamma,
+	input wire [3:0] i_bg_color,
+	input wire [3:0] i_fg_color,
+	input wire [3:0] i_fg_alpha,
+	output reg [3:0] o_color
+);
+
+	function [7:0] linearize;
+		input [3:0] color;
+		begin
+			case (color)
+				4'h0: linearize = 8'd0;
+				4'h1: linearize = 8'd1;
+				4'h2: linearize = 8'd3;
+				4'h3: linearize = 8'd7;
+				4'h4: linearize = 8'd14;
+				4'h5: linearize = 8'd23;
+				4'h6: linearize = 8'd34;
+				4'h7: linearize = 8'd48;
+				4'h8: linearize = 8'd64;
+				4'h9: linearize = 8'd83;
+				4'hA: linearize = 8'd105;
+				4'hB: linearize = 8'd129;
+				4'hC: linearize = 8'd156;
+				4'hD: linearize = 8'd186;
+				4'hE: linearize = 8'd219;
+				4'hF: linearize = 8'd255;
+			endcase
+		end
+	endfunction
+
+	function [3:0] delinearize;
+		input [7:0] light;
+		begin
+			delinearize =
+				{3'b0, light >= 8'd1} + {3'b0, light >= 8'd2} +
+				{3'b0, light >= 8'd5} + {3'b0, light >= 8'd11} +
+				{3'b0, light >= 8'd19} + {3'b0, light >= 8'd29} +
+				{3'b0, light >= 8'd41} + {3'b0, light >= 8'd56} +
+				{3'b0, light >= 8'd74} + {3'b0, light >= 8'd94} +
+				{3'b0, light >= 8'd117} + {3'b0, light >= 8'd143} +
+				{3'b0, light >= 8'd171} + {3'b0, light >= 8'd203} +
+				{3'b0, light >= 8'd237};
+		end
+	endfunction
+
+	wire [3:0] plain_color;
+
+	component_blender plain_blender (
+		.i_bg_color(i_bg_color),
+		.i_fg_color(i_fg_color),
+		.i_fg_alpha(i_fg_alpha),
+		.o_color(plain_color)
+	);
+
+	// Stage 1
+	reg [7:0] s1_bg_light;
+	reg [7:0] s1_fg_light;
+	reg [3:0] s1_alpha;
+	reg [3:0] s1_plain;
+	reg s1_gamma;
+
+	// Stage 2
+	reg [7:0] s2_light;
+	reg [3:0] s2_plain;
+	reg s2_gamma;
+
+	// round(sum / 15) for sum in 0..3825, as (sum * 273 + 2166) >> 12,
+	// where 273 = 256 + 16 + 1.
+	wire [3:0] s1_bg_alpha = ~s1_alpha; // 15 - s1_alpha
+	wire [11:0] light_sum = s1_fg_light * s1_alpha + s1_bg_light * s1_bg_alpha;
+	wire [20:0] light_scaled = {light_sum, 8'b0} + {5'b0, light_sum, 4'b0} +
+		{9'b0, light_sum} + 21'd2166;
+
+	always @(posedge i_clk) begin
+		s1_bg_light <= linearize(i_bg_color);
+		s1_fg_light <= linearize(i_fg_color);
+		s1_alpha <= i_fg_alpha;
+		s1_plain <= plain_color;
+		s1_gamma <= i_gamma;
+
+		s2_light <= light_scaled[19:12];
+		s2_plain <= s1_plain;
+		s2_gamma <= s1_gamma;
+
+		o_color <= s2_gamma ? delinearize(s2_light) : s2_plain;
+	end
+
+endmodule
@@ -0,0 +1,296 @@
+/*
+ * glyph_cache.v
+ *
+ * This module keeps the glyph table used by the text area (char_gen8x8.v)
+ * filled from a large glyph set in PSRAM, in the engine domain, so that
+ * text cells can hold 16-bit code points (multilingual text) while the
+ * glyph table in BRAM only holds 256 glyphs.
+ *
+ * The glyph table is a 2-way set associative cache: the glyph for code
+ * point C can only be in set C[6:0], in glyph slot {way, C[6:0]}, and each
+ * slot has a tag {valid, C[15:7]}. The text area looks up each cell's
+ * code point in the tags; a cell whose glyph is not in the cache is shown
+ * as its background color alone, and its code point is reported as a miss
+ * (through a small FIFO, see ogege.v). At power on, the cache holds code
+ * points 0 to 255 (the BRAM font), in slot C.
+ *
+ * A miss reported while the FIFO is full is dropped. i_miss_dropped pulses
+ * (in the pixel domain) for each one, and they are counted here (carried
+ * by a toggle, synchronized in the engine domain), so that the host can
+ * tell when misses have been lost.
+ *
+ * The glyph set in PSRAM holds 16 words per glyph, from GLYPH_BASE:
+ *
+ *  address = GLYPH_BASE + C * 16 + row * 2 + half
+ *
+ * where each word holds 4 pixels of one glyph row (half 0: columns 0-3,
+ * half 1: columns 4-7), as 4-bit alpha codes, the leftmost pixel in the
+ * low bits.
+ *
+ * Replacement is either automatic or managed by the host. With AUTO set,
+ * each missing code point is loaded on its own, over the way of its set
+ * that was filled least recently. The host may also load a code point into
+ * a chosen way itself (FILL), for example to keep the glyphs of a status
+ * line in the cache. While a slot is being loaded, its tag is invalid, so
+ * cells using it show their background color.
+ *
+ * Host register writes (i_reg_we, i_reg_addr, i_reg_data):
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   GLYPH_BASE 23:0   PSRAM address of the glyph for code point 0
+ *   1   CONTROL    0      AUTO: 1 = load missing glyphs automatically
+ *   2   FILL       16     Way to load into
+ *                  15:0   Code point to load
+ *
+ * Host register reads (i_rd_addr, o_rd_data), for readback space 6:
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   MISSES     31:0   Misses reported by the text area
+ *   1   FILLS      31:0   Glyphs loaded from PSRAM
+ *   2   LAST_MISS  15:0   Code point of the last miss reported
+ *   3   STATUS     1      A glyph is being loaded (or a FILL waits)
+ *                  0      AUTO
+ *   4   DROPPED    31:0   Misses dropped, as the miss FIFO was full
+ *
+ * The text area reports a miss each time the missing code point differs
+ * from the one it reported last, so MISSES counts runs of missing cells,
+ * not pixels. MISSES counts the misses taken from the FIFO, so MISSES plus
+ * DROPPED is every miss reported. Writing GLYPH_BASE clears the counters.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module glyph_cache (
+    input  wire i_rst,
+    input  wire i_clk,
+    input  wire i_reg_we,
+    input  wire [1:0] i_reg_addr,
+    input  wire [31:0] i_reg_data,
+    input  wire [2:0] i_rd_addr,
+    output reg  [31:0] o_rd_data,
+    input  wire i_pix_clk,
+    input  wire i_miss_dropped,
+    input  wire i_miss_empty,
+    input  wire [15:0] i_miss_code,
+    output wire o_miss_pop,
+    output reg  o_mem_req,
+    output reg  [23:0] o_mem_addr,
+    input  wire i_mem_ack,
+    input  wire [15:0] i_mem_data,
+    output reg  o_glyph_we,
+    output wire [13:0] o_glyph_addr,
+    output wire [3:0] o_glyph_data,
+    output reg  o_tag_we,
+    output reg  o_tag_way,
+    output reg  [6:0] o_tag_set,
+    output reg  [9:0] o_tag_data
+);
+
+    localparam REG_GLYPH_BASE = 2'd0;
+    localparam REG_CONTROL = 2'd1;
+    localparam REG_FILL = 2'd2;
+
+    localparam F_IDLE = 2'd0;
+    localparam F_READ = 2'd1;
+    localparam F_WRITE = 2'd2;
+    localparam F_TAG = 2'd3;
+
+    reg [23:0] reg_glyph_base;
+    reg reg_auto;
+    reg [31:0] reg_misses;
+    reg [31:0] reg_fills;
+    reg [15:0] reg_last_miss;
+    reg [31:0] reg_dropped;
+
+    // Dropped misses: a toggle in the pixel domain, and its synchronizer.
+    reg reg_drop_toggle;
+    reg [2:0] reg_drop_sync;
+
+    // A FILL from the host, waiting for the current load to finish.
+    reg reg_host_fill;
+    reg reg_host_way;
+    reg [15:0] reg_host_code;
+
+    // A copy of the tags in the text area, and the way of each set that
+    // was filled least recently.
+    reg [9:0] shadow0 [0:127];
+    reg [9:0] shadow1 [0:127];
+    reg [127:0] reg_victim;
+
+    // The glyph being loaded.
+    reg [1:0] reg_state;
+    reg [15:0] reg_code;
+    reg reg_way;
+    reg [3:0] reg_word;
+    reg [1:0] reg_nibble;
+    reg [15:0] reg_data;
+
+    integer k;
+
+    initial begin
+        for (k = 0; k < 128; k = k + 1) begin
+            shadow0[k] = {1'b1, 9'd0};
+            shadow1[k] = {1'b1, 9'd1};
+        end
+    end
+
+    wire [6:0] miss_set = i_miss_code[6:0];
+    wire [9:0] miss_tag = {1'b1, i_miss_code[15:7]};
+    wire miss_cached = (shadow0[miss_set] == miss_tag) | (shadow1[miss_set] == miss_tag);
+    wire idle = (reg_state == F_IDLE);
+
+    assign o_miss_pop = ~i_miss_empty & idle & ~reg_host_fill;
+
+    // The load to start on this clock, if any: a FILL from the host, or a
+    // missing code point.
+    wire start_host = idle & reg_host_fill;
+    wire start_miss = o_miss_pop & reg_auto & ~miss_cached;
+    wire start = start_host | start_miss;
+    wire [15:0] start_code = start_host ? reg_host_code : i_miss_code;
+    wire start_way = start_host ? reg_host_way : reg_victim[miss_set];
+
+    assign o_glyph_addr = {reg_way, reg_code[6:0], reg_word, reg_nibble};
+    assign o_glyph_data = reg_data[reg_nibble*4 +: 4];
+
+    always @(*) begin
+        case (i_rd_addr)
+            3'd0: o_rd_data = reg_misses;
+            3'd1: o_rd_data = reg_fills;
+            3'd2: o_rd_data = {16'd0, reg_last_miss};
+            3'd3: o_rd_data = {30'd0, ~idle | reg_host_fill, reg_auto};
+            default: o_rd_data = reg_dropped;
+        endcase
+    end
+
+    always @(posedge i_rst or posedge i_pix_clk) begin
+        if (i_rst)
+            reg_drop_toggle <= 0;
+        else if (i_miss_dropped)
+            reg_drop_toggle <= ~reg_drop_toggle;
+    end
+
+    // Starting a load records the new tag in the shadow copy at once, so
+    // later misses for the same code point are not loaded twice.
+    always @(posedge i_clk) begin
+        if (start) begin
+            if (start_way)
+                shadow1[start_code[6:0]] <= {1'b1, start_code[15:7]};
+            else
+                shadow0[start_code[6:0]] <= {1'b1, start_code[15:7]};
+        end
+    end
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_glyph_base <= 0;
+            reg_auto <= 0;
+            reg_misses <= 0;
+            reg_fills <= 0;
+            reg_last_miss <= 0;
+            reg_dropped <= 0;
+            reg_drop_sync <= 0;
+            reg_host_fill <= 0;
+            reg_host_way <= 0;
+            reg_host_code <= 0;
+            reg_victim <= 0;
+            reg_state <= F_IDLE;
+            reg_code <= 0;
+            reg_way <= 0;
+            reg_word <= 0;
+            reg_nibble <= 0;
+            reg_data <= 0;
+            o_mem_req <= 0;
+            o_mem_addr <= 0;
+            o_glyph_we <= 0;
+            o_tag_we <= 0;
+            o_tag_way <= 0;
+            o_tag_set <= 0;
+            o_tag_data <= 0;
+        end else begin
+            o_tag_we <= 0;
+            o_glyph_we <= 0;
+
+            // The toggle changes at most once per pixel clock, so each
+            // change is seen.
+            reg_drop_sync <= {reg_drop_sync[1:0], reg_drop_toggle};
+            if (reg_drop_sync[2] != reg_drop_sync[1])
+                reg_dropped <= reg_dropped + 1;
+
+            case (reg_state)
+                F_IDLE: begin
+                        if (start_host)
+                            reg_host_fill <= 0;
+                        if (o_miss_pop) begin
+                            reg_misses <= reg_misses + 1;
+                            reg_last_miss <= i_miss_code;
+                        end
+                        if (start) begin
+                            // The slot's tag is invalid while it is loaded.
+                            reg_code <= start_code;
+                            reg_way <= start_way;
+                            reg_word <= 0;
+                            reg_nibble <= 0;
+                            reg_victim[start_code[6:0]] <= ~start_way;
+                            o_tag_we <= 1;
+                            o_tag_way <= start_way;
+                            o_tag_set <= start_code[6:0];
+                            o_tag_data <= {1'b0, start_code[15:7]};
+                            reg_state <= F_READ;
+                        end
+                    end
+                F_READ: begin
+                        if (~o_mem_req) begin
+                            o_mem_req <= 1;
+                            o_mem_addr <= reg_glyph_base + {4'd0, reg_code, 4'd0} + reg_word;
+                        end else if (i_mem_ack) begin
+                            o_mem_req <= 0;
+                            reg_data <= i_mem_data;
+                            o_glyph_we <= 1;
+                            reg_nibble <= 0;
+                            reg_state <= F_WRITE;
+                        end
+                    end
+                F_WRITE: begin
+                        if (reg_nibble == 3) begin
+                            reg_word <= reg_word + 1;
+                            reg_state <= (reg_word == 15) ? F_TAG : F_READ;
+                        end else begin
+                            o_glyph_we <= 1;
+                        end
+                        reg_nibble <= reg_nibble + 1;
+                    end
+                default: begin
+                        o_tag_we <= 1;
+                        o_tag_way <= reg_way;
+                        o_tag_set <= reg_code[6:0];
+                        o_tag_data <= {1'b1, reg_code[15:7]};
+                        reg_fills <= reg_fills + 1;
+                        reg_state <= F_IDLE;
+                    end
+            endcase
+
+            if (i_reg_we) begin
+                case (i_reg_addr)
+                    REG_GLYPH_BASE: begin
+                            reg_glyph_base <= i_reg_data[23:0];
+                            reg_misses <= 0;
+                            reg_fills <= 0;
+                            reg_dropped <= 0;
+                        end
+                    REG_CONTROL: reg_auto <= i_reg_data[0];
+                    REG_FILL: begin
+                            reg_host_fill <= 1;
+                            reg_host_way <= i_reg_data[16];
+                            reg_host_code <= i_reg_data[15:0];
+                        end
+                endcase
+            end
+        end
+    end
+
+endmodule
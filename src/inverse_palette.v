@@ -0,0 +1,332 @@
+/*
+ * inverse_palette.v
+ *
+ * This module holds the inverse palette: a table of 4096 palette indexes,
+ * one for each 12-bit RGB color, giving the canvas palette entry nearest
+ * to that color. Engine operations that make new colors (such as blended
+ * blits, see sprite_blit.v) use it to store those colors in the frame
+ * buffer, which holds palette indexes.
+ *
+ * The nearest entry is the one with the smallest squared distance
+ * (dr*dr + dg*dg + db*db, on the 4-bit components), and the lowest index
+ * of those that tie. model/inverse_palette.c computes the same table on
+ * the host, entry for entry, for host drawing and for checking.
+ *
+ * The module keeps its own copy of the canvas palette, by watching the
+ * canvas palette commands (00000100) as they enter the command FIFO, and
+ * keeps the table up to date as the palette changes:
+ *
+ *  - After reset, or when the host asks (REGEN), the whole table is
+ *    generated: each color is compared with all 256 entries, one per
+ *    clock (about 1.05 million clocks, 10.5 ms at 100 MHz).
+ *
+ *  - With AUTO set, each palette entry that changes is marked, and the
+ *    table is then updated for that entry alone (an incremental pass):
+ *    each color moves to the changed entry if it is now nearer than the
+ *    color's current entry, and each color whose current entry is the
+ *    changed one is compared with all 256 entries again. A pass takes
+ *    about 12,300 clocks, plus 257 for each color compared again.
+ *
+ *  - When FULL_LIMIT entries are marked, a whole generation is quicker
+ *    than the passes, so one is done instead.
+ *
+ * While the table is being updated, lookups may give a color's old entry.
+ *
+ * Host register writes (i_reg_we, i_reg_addr, i_reg_data):
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   ENTRY      19:8   RGB color
+ *                  7:0    Palette index to give for that color (ignored
+ *                         while the table is being updated)
+ *   1   CONTROL    1      REGEN: 1 = generate the whole table
+ *                  0      AUTO: 1 = update the table as the palette
+ *                         changes (the default)
+ *
+ * Host register reads (i_rd_addr, o_rd_data), for readback space 7:
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   STATUS     17     A whole generation is waiting or in progress
+ *                  16     The table is being updated
+ *                  8:0    Palette entries marked, waiting for a pass
+ *   1   PASSES     31:0   Incremental passes done
+ *   2   RESCANS    31:0   Colors compared with all entries in passes
+ *   3   REGENS     31:0   Whole generations done
+ *
+ * The lookup port (i_lut_addr, o_lut_index) is registered: the index for
+ * the color given on one clock is ready after the next rising edge.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module inverse_palette #(
+        parameter FULL_LIMIT=64
+    )(
+        input  wire i_rst,
+        input  wire i_clk,
+        input  wire i_reg_we,
+        input  wire [1:0] i_reg_addr,
+        input  wire [31:0] i_reg_data,
+        input  wire [1:0] i_rd_addr,
+        output reg  [31:0] o_rd_data,
+        input  wire i_cmd_valid,
+        input  wire [31:0] i_cmd_data,
+        input  wire [11:0] i_lut_addr,
+        output reg  [7:0] o_lut_index
+    );
+
+    localparam REG_ENTRY = 2'd0;
+    localparam REG_CONTROL = 2'd1;
+
+    localparam G_IDLE = 3'd0;
+    localparam G_NEW = 3'd1;
+    localparam G_LUT = 3'd2;
+    localparam G_PAL = 3'd3;
+    localparam G_CMP = 3'd4;
+    localparam G_SCAN = 3'd5;
+
+    function [9:0] distance;
+        input [11:0] a;
+        input [11:0] b;
+        reg [3:0] dr, dg, db;
+        begin
+            dr = (a[11:8] > b[11:8]) ? (a[11:8] - b[11:8]) : (b[11:8] - a[11:8]);
+            dg = (a[7:4] > b[7:4]) ? (a[7:4] - b[7:4]) : (b[7:4] - a[7:4]);
+            db = (a[3:0] > b[3:0]) ? (a[3:0] - b[3:0]) : (b[3:0] - a[3:0]);
+            distance = dr * dr + dg * dg + db * db;
+        end
+    endfunction
+
+    reg [7:0] indexes [0:4095];
+    reg [7:0] reg_doa;
+
+    reg reg_auto;
+    reg reg_full_pending;
+    reg [31:0] reg_passes;
+    reg [31:0] reg_rescans;
+    reg [31:0] reg_regens;
+
+    // Palette entries changed since their last pass, and the next one to
+    // look at.
+    reg [255:0] reg_dirty;
+    reg [8:0] reg_dirty_count;
+    reg [7:0] reg_scan;
+
+    // The update in progress: the color being looked at, the changed entry
+    // and its new color (in a pass), and the scan of all entries.
+    reg [2:0] reg_state;
+    reg reg_full;
+    reg [11:0] reg_color;
+    reg [7:0] reg_pass_entry;
+    reg [11:0] reg_new_color;
+    reg [8:0] reg_entry;
+    reg [7:0] reg_cand;
+    reg reg_cand_valid;
+    reg [7:0] reg_best;
+    reg [9:0] reg_best_d;
+
+    integer k;
+
+    initial begin
+        for (k = 0; k < 4096; k = k + 1) begin
+            indexes[k] = 8'd0;
+        end
+    end
+
+    wire idle = (reg_state == G_IDLE);
+    wire pal_we = i_cmd_valid & (i_cmd_data[31:24] == 8'b00000100);
+    wire [7:0] pal_index = i_cmd_data[19:12];
+    wire mark = pal_we & reg_auto;
+    wire start_full = idle & reg_full_pending;
+    wire pick = idle & ~reg_full_pending & reg_dirty[reg_scan] &
+                ~(pal_we & (pal_index == reg_scan));
+
+    // The copy of the canvas palette: port A takes the palette commands,
+    // and port B reads entries for the update.
+    wire [11:0] pal_color;
+    wire [7:0] pal_addrb = (reg_state == G_SCAN) ? reg_entry[7:0] :
+                           (reg_state == G_PAL) ? reg_doa : reg_scan;
+
+    palette #(
+        .ADDR_WIDTH(8),
+        .INIT_FILE("../image/car336x256x256.pal")
+    ) palette_copy (
+        .wea(pal_we),
+        .web(1'b0),
+        .clka(i_clk),
+        .clkb(i_clk),
+        .dia(i_cmd_data[11:0]),
+        .dib(12'd0),
+        .addra(pal_index),
+        .addrb(pal_addrb),
+        .doa(),
+        .dob(pal_color)
+    );
+
+    // Pass: is the changed entry nearer than the color's current entry?
+    wire [9:0] d_old = distance(reg_color, pal_color);
+    wire [9:0] d_new = distance(reg_color, reg_new_color);
+    wire owned = (reg_doa == reg_pass_entry);
+    wire nearer = (d_new < d_old) | ((d_new == d_old) & (reg_pass_entry < reg_doa));
+
+    // Scan: the nearest entry so far, including the one read on this clock.
+    wire scan_last = reg_cand_valid & (reg_cand == 8'd255);
+    wire scan_nearer = reg_cand_valid & ((reg_cand == 0) | (d_old < reg_best_d));
+    wire [7:0] scan_best = scan_nearer ? reg_cand : reg_best;
+    wire last_color = (reg_color == 12'hFFF);
+
+    // Port A of the table: the update, or a host ENTRY write when idle.
+    wire host_we = i_reg_we & (i_reg_addr == REG_ENTRY) & idle;
+    wire lut_we = host_we | ((reg_state == G_CMP) & ~owned & nearer) |
+                  ((reg_state == G_SCAN) & scan_last);
+    wire [11:0] lut_addra = host_we ? i_reg_data[19:8] : reg_color;
+    wire [7:0] lut_dia = host_we ? i_reg_data[7:0] :
+                         (reg_state == G_CMP) ? reg_pass_entry : scan_best;
+
+    always @(posedge i_clk) begin
+        if (lut_we)
+            indexes[lut_addra] <= lut_dia;
+        else
+            reg_doa <= indexes[lut_addra];
+    end
+
+    always @(posedge i_clk) begin
+        o_lut_index <= indexes[i_lut_addr];
+    end
+
+    always @(*) begin
+        case (i_rd_addr)
+            2'd0: o_rd_data = {14'd0, reg_full_pending | reg_full, ~idle, 7'd0, reg_dirty_count};
+            2'd1: o_rd_data = reg_passes;
+            2'd2: o_rd_data = reg_rescans;
+            default: o_rd_data = reg_regens;
+        endcase
+    end
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_auto <= 1;
+            reg_full_pending <= 1;
+            reg_passes <= 0;
+            reg_rescans <= 0;
+            reg_regens <= 0;
+            reg_dirty <= 0;
+            reg_dirty_count <= 0;
+            reg_scan <= 0;
+            reg_state <= G_IDLE;
+            reg_full <= 0;
+            reg_color <= 0;
+            reg_pass_entry <= 0;
+            reg_new_color <= 0;
+            reg_entry <= 0;
+            reg_cand <= 0;
+            reg_cand_valid <= 0;
+            reg_best <= 0;
+            reg_best_d <= 0;
+        end else begin
+            case (reg_state)
+                G_IDLE: begin
+                        if (start_full) begin
+                            reg_full_pending <= 0;
+                            reg_full <= 1;
+                            reg_color <= 0;
+                            reg_entry <= 0;
+                            reg_cand_valid <= 0;
+                            reg_state <= G_SCAN;
+                        end else if (pick) begin
+                            // The entry's new color is read on this clock.
+                            reg_pass_entry <= reg_scan;
+                            reg_state <= G_NEW;
+                        end else
+                            reg_scan <= reg_scan + 1;
+                    end
+                G_NEW: begin
+                        reg_new_color <= pal_color;
+                        reg_color <= 0;
+                        reg_state <= G_LUT;
+                    end
+                G_LUT: begin
+                        // The color's current entry is read on this clock,
+                        reg_state <= G_PAL;
+                    end
+                G_PAL: begin
+                        // and that entry's color on this one.
+                        reg_state <= G_CMP;
+                    end
+                G_CMP: begin
+                        if (owned) begin
+                            reg_entry <= 0;
+                            reg_cand_valid <= 0;
+                            reg_state <= G_SCAN;
+                        end else if (last_color) begin
+                            reg_passes <= reg_passes + 1;
+                            reg_state <= G_IDLE;
+                        end else begin
+                            reg_color <= reg_color + 1;
+                            reg_state <= G_LUT;
+                        end
+                    end
+                default: begin
+                        // Entry reg_entry is read on this clock, and the
+                        // color of entry reg_cand is on pal_color.
+                        if (~reg_entry[8])
+                            reg_entry <= reg_entry + 1;
+                        reg_cand <= reg_entry[7:0];
+                        reg_cand_valid <= ~reg_entry[8];
+                        if (scan_nearer) begin
+                            reg_best <= reg_cand;
+                            reg_best_d <= d_old;
+                        end
+                        if (scan_last) begin
+                            if (reg_full) begin
+                                if (last_color) begin
+                                    reg_full <= 0;
+                                    reg_regens <= reg_regens + 1;
+                                    reg_state <= G_IDLE;
+                                end else begin
+                                    reg_color <= reg_color + 1;
+                                    reg_entry <= 0;
+                                    reg_cand_valid <= 0;
+                                end
+                            end else begin
+                                reg_rescans <= reg_rescans + 1;
+                                if (last_color) begin
+                                    reg_passes <= reg_passes + 1;
+                                    reg_state <= G_IDLE;
+                                end else begin
+                                    reg_color <= reg_color + 1;
+                                    reg_state <= G_LUT;
+                                end
+                            end
+                        end
+                    end
+            endcase
+
+            // Marking changed palette entries, and clearing them as their
+            // passes start (or all of them, as a whole generation starts).
+            if (start_full) begin
+                reg_dirty <= 0;
+                reg_dirty_count <= {8'd0, mark};
+            end else begin
+                if (pick)
+                    reg_dirty[reg_scan] <= 0;
+                reg_dirty_count <= reg_dirty_count + (mark & ~reg_dirty[pal_index]) - pick;
+                if (reg_dirty_count >= FULL_LIMIT)
+                    reg_full_pending <= 1;
+            end
+            if (mark)
+                reg_dirty[pal_index] <= 1;
+
+            if (i_reg_we & (i_reg_addr == REG_CONTROL)) begin
+                reg_auto <= i_reg_data[0];
+                if (i_reg_data[1])
+                    reg_full_pending <= 1;
+            end
+        end
+    end
+
+endmodule
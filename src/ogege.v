@@ -5,6 +5,18 @@
  * registers needed to generate the entire display, and supports reading and
  * writing those registers from an external application standpoint.
  *
+ * The design has two clock domains:
+ *
+ *  Engine domain (clk_100mhz): the PSRAM controller, host command intake,
+ *  and other non-display work, which run four times faster than pixels.
+ *
+ *  Pixel domain (pix_clk, 25 MHz): the VGA timing and the display layers.
+ *
+ * Commands cross from the engine domain to the pixel domain through a
+ * dual-clock FIFO (cmd_fifo), and answers to display reads come back
+ * through another (see readback.v). The frame buffer is shared by time slicing
+ * (see canvas.v), rather than by a FIFO.
+ *
  * Copyright (C) 2024 Curtis Whitley
  * License: APACHE
  */
@@ -37,11 +49,15 @@ module ogege (
 wire clk_100mhz, pix_clk, clk_locked;
 reg [11:0] reg_fg_color = 12'b111111111111;
 reg [11:0] reg_bg_color = 12'b000000000000;
+wire [11:0] canvas_color;
 wire [11:0] new_color;
 wire [9:0] h_count_s;
-wire [8:0] v_count_s;
+wire [9:0] v_count_s;
 wire rst_s;
 wire active_s;
+wire hsync_s;
+wire vsync_s;
+wire display_active;
 wire blank_s;
 reg [3:0] glyph_row_count;
 wire [2:0] cell_col_count;
@@ -49,6 +65,8 @@ reg [4:0] text_row_count;
 
 reg reg_cmd_clk = 1'b0;
 reg [31:0] reg_cmd_data = 32'd0;
+reg [2:0] reg_cmd_step = 3'd0;
+reg reg_cmd_idle = 1'b1;
 reg [5:0] reg_frame_count = 6'd0;
 reg [9:0] reg_scroll_x_offset = 10'd0;
 reg [8:0] reg_scroll_y_offset = 9'd0;
@@ -87,20 +105,40 @@ end
 
 vga_core #(
 	.HSZ(10),
-	.VSZ(9)
+	.VSZ(10)
 ) vga_inst (.clk_i(pix_clk),
     .rst_i(~clk_locked),
 	.hcount_o(h_count_s),
 	.vcount_o(v_count_s),
 	.de_o(active_s),
-	.vsync_o(o_vsync),
-	.hsync_o(o_hsync)
+	.vsync_o(vsync_s),
+	.hsync_o(hsync_s)
 );
 
+// The display layers give the color for a scan position DISPLAY_LATENCY
+// pixel clocks after it (see text_area8x8.v, which includes the canvas).
+// The display enable and sync from vga_core already trail the scan position
+// by 1 clock, so they are delayed by the rest, to stay with their pixels.
+//
+localparam DISPLAY_LATENCY = 9;
+localparam SYNC_DELAY = DISPLAY_LATENCY - 1;
+reg [SYNC_DELAY-1:0] reg_active_pipe;
+reg [SYNC_DELAY-1:0] reg_hsync_pipe;
+reg [SYNC_DELAY-1:0] reg_vsync_pipe;
+
+always @(posedge pix_clk) begin
+	reg_active_pipe <= {reg_active_pipe[SYNC_DELAY-2:0], active_s};
+	reg_hsync_pipe <= {reg_hsync_pipe[SYNC_DELAY-2:0], hsync_s};
+	reg_vsync_pipe <= {reg_vsync_pipe[SYNC_DELAY-2:0], vsync_s};
+end
+
+assign display_active = reg_active_pipe[SYNC_DELAY-1];
+assign o_hsync = reg_hsync_pipe[SYNC_DELAY-1];
+assign o_vsync = reg_vsync_pipe[SYNC_DELAY-1];
+
 assign cell_col_count = h_count_s[2:0];
 
 always @(posedge pix_clk) begin
-	reg_cmd_clk = 0;
 	if (h_count_s == 639) begin
 		if (v_count_s == 479) begin
 			glyph_row_count <= 0;
@@ -113,123 +151,623 @@ always @(posedge pix_clk) begin
 	end
 end
 
-/*
-text_area8x8 text_area8x8_inst (
+// Engine domain command intake. There is no host link yet; host commands
+// and host register writes will be given here, at the engine clock rate.
+// The command processor passes them into the command FIFO, along with the
+// commands it fetches from the command ring in PSRAM.
+//
+reg reg_host_cmd_valid = 1'b0;
+reg [31:0] reg_host_cmd_data = 32'd0;
+reg reg_host_reg_we = 1'b0;
+reg [3:0] reg_host_reg_addr = 4'd0;
+reg [31:0] reg_host_reg_data = 32'd0;
+wire host_cmd_ready;
+wire [22:0] ring_tail;
+wire call_overflow;
+wire [23:0] last_fence;
+wire fence_done;
+wire [31:0] frame_count;
+wire [9:0] scan_line;
+wire cmd_valid;
+wire [31:0] cmd_data;
+wire cmd_fifo_full;
+wire cmd_fifo_wr_empty;
+wire cmd_fifo_empty;
+wire [31:0] cmd_fifo_data;
+reg reg_cmd_pop;
+wire ring_mem_req;
+wire [23:0] ring_mem_addr;
+wire [3:0] reg_rd_addr;
+wire [31:0] reg_rd_data;
+wire evt_rd_en;
+wire [31:0] evt_rd_data;
+wire host_irq;
+wire [31:0] edge_rd_data;
+wire column_event;
+wire [23:0] column_tag;
+wire row_event;
+wire [23:0] row_tag;
+
+// The glyph cache: its register writes are placeholders until there is a
+// host link. Glyph misses from the text area (pixel domain) are carried
+// to it by a small FIFO.
+//
+reg reg_glyph_reg_we = 1'b0;
+reg [1:0] reg_glyph_reg_addr = 2'd0;
+reg [31:0] reg_glyph_reg_data = 32'd0;
+wire [31:0] glyph_rd_data;
+wire glyph_mem_req;
+wire [23:0] glyph_mem_addr;
+wire glyph_we;
+wire [13:0] glyph_addr;
+wire [3:0] glyph_data;
+wire glyph_tag_we;
+wire glyph_tag_way;
+wire [6:0] glyph_tag_set;
+wire [9:0] glyph_tag_data;
+wire text_miss_valid;
+wire [15:0] text_miss_code;
+wire miss_fifo_full;
+wire miss_fifo_empty;
+wire [15:0] miss_fifo_data;
+wire miss_fifo_pop;
+
+// Host reads, answered by the readback module. There is no host link yet,
+// so these are placeholders too.
+//
+reg reg_host_rd_valid = 1'b0;
+reg [3:0] reg_host_rd_space = 4'd0;
+reg [19:0] reg_host_rd_addr = 20'd0;
+reg [7:0] reg_host_rd_tag = 8'd0;
+wire host_rd_ready;
+wire host_rsp_valid;
+wire [7:0] host_rsp_tag;
+wire [31:0] host_rsp_data;
+wire rb_cmd_valid;
+wire [31:0] rb_cmd_data;
+wire fb_rd_stb;
+wire [8:0] fb_rd_col;
+wire [7:0] fb_rd_row;
+wire fb_rd_grant;
+wire fb_rd_valid;
+wire [7:0] fb_rd_data;
+wire canvas_rd_valid;
+wire [31:0] canvas_rd_data;
+wire text_rd_valid;
+wire [31:0] text_rd_data;
+wire disp_rd_valid;
+wire [31:0] disp_rd_data;
+wire rsp_fifo_empty;
+wire [31:0] rsp_fifo_data;
+wire rsp_fifo_pop;
+
+// Viewport streaming from a world in PSRAM into the canvas frame buffer.
+// Its register writes are placeholders until there is a host link.
+//
+reg reg_stream_reg_we = 1'b0;
+reg [1:0] reg_stream_reg_addr = 2'd0;
+reg [31:0] reg_stream_reg_data = 32'd0;
+wire stream_mem_req;
+wire [23:0] stream_mem_addr;
+wire stream_blit_stb;
+wire [8:0] stream_blit_col;
+wire [7:0] stream_blit_row;
+wire [7:0] stream_blit_data;
+wire stream_cmd_valid;
+wire [31:0] stream_cmd_data;
+
+// Proportional string drawing into the canvas frame buffer. Its register
+// writes are placeholders until there is a host link.
+//
+reg reg_str_reg_we = 1'b0;
+reg [2:0] reg_str_reg_addr = 3'd0;
+reg [31:0] reg_str_reg_data = 32'd0;
+wire str_done;
+wire [23:0] str_done_tag;
+wire str_mem_req;
+wire [23:0] str_mem_addr;
+wire str_blit_stb;
+wire [8:0] str_blit_col;
+wire [7:0] str_blit_row;
+wire [7:0] str_blit_data;
+
+// Alpha blended sprite blits into the canvas frame buffer, and the inverse
+// palette they use. Their register writes are placeholders until there is
+// a host link.
+//
+reg reg_sprite_reg_we = 1'b0;
+reg [1:0] reg_sprite_reg_addr = 2'd0;
+reg [31:0] reg_sprite_reg_data = 32'd0;
+reg reg_ipal_reg_we = 1'b0;
+reg [1:0] reg_ipal_reg_addr = 2'd0;
+reg [31:0] reg_ipal_reg_data = 32'd0;
+wire [31:0] ipal_rd_data;
+wire sprite_done;
+wire [23:0] sprite_done_tag;
+wire sprite_mem_req;
+wire [23:0] sprite_mem_addr;
+wire sprite_blit_stb;
+wire sprite_blit_we;
+wire [8:0] sprite_blit_col;
+wire [7:0] sprite_blit_row;
+wire [7:0] sprite_blit_data;
+wire [11:0] lut_addr;
+wire [7:0] lut_index;
+
+// The signature of each frame shown, for checking scenes on the board.
+// Its register writes are placeholders until there is a host link.
+//
+reg reg_crc_reg_we = 1'b0;
+reg reg_crc_reg_addr = 1'b0;
+reg [31:0] reg_crc_reg_data = 32'd0;
+wire [31:0] crc_rd_data;
+
+// The canvas blit port is shared: streamer writes go ahead of string
+// writes, then sprite blit accesses, then frame buffer reads. A frame
+// buffer answer goes to the readback module only if its read was taken.
+//
+wire blit_grant;
+wire blit_stb = stream_blit_stb | str_blit_stb | sprite_blit_stb | fb_rd_stb;
+wire blit_we = stream_blit_stb | str_blit_stb | (sprite_blit_stb & sprite_blit_we);
+wire [8:0] blit_col = stream_blit_stb ? stream_blit_col :
+                      str_blit_stb ? str_blit_col :
+                      sprite_blit_stb ? sprite_blit_col : fb_rd_col;
+wire [7:0] blit_row = stream_blit_stb ? stream_blit_row :
+                      str_blit_stb ? str_blit_row :
+                      sprite_blit_stb ? sprite_blit_row : fb_rd_row;
+wire [7:0] blit_data = stream_blit_stb ? stream_blit_data :
+                       str_blit_stb ? str_blit_data : sprite_blit_data;
+wire sprite_blit_grant = blit_grant & ~stream_blit_stb & ~str_blit_stb;
+assign fb_rd_grant = sprite_blit_grant & ~sprite_blit_stb;
+reg reg_fb_rd_taken = 1'b0;
+
+always @(posedge clk_100mhz) begin
+	reg_fb_rd_taken <= fb_rd_stb & fb_rd_grant;
+end
+
+// READ display commands from the readback module go ahead of the
+// streamer's scroll commands, which go ahead of direct host commands.
+//
+wire proc_host_valid = rb_cmd_valid | stream_cmd_valid | reg_host_cmd_valid;
+wire [31:0] proc_host_data = rb_cmd_valid ? rb_cmd_data :
+                             stream_cmd_valid ? stream_cmd_data : reg_host_cmd_data;
+
+readback #(
+	.RSP_ADDR_WIDTH(4)
+) readback_inst (
 	.i_rst(rst_s),
-	.i_pix_clk(pix_clk),
-	.i_blank(blank_s),
-    .i_cmd_clk(reg_cmd_clk),
-    .i_cmd_data(reg_cmd_data),
-	.i_scan_row(v_count_s),
-	.i_scan_column(h_count_s),
-	.i_bg_color(reg_bg_color),
-	.o_color(new_color)
+	.i_clk(clk_100mhz),
+	.i_req_valid(reg_host_rd_valid),
+	.i_req_space(reg_host_rd_space),
+	.i_req_addr(reg_host_rd_addr),
+	.i_req_tag(reg_host_rd_tag),
+	.o_req_ready(host_rd_ready),
+	.o_rsp_valid(host_rsp_valid),
+	.o_rsp_tag(host_rsp_tag),
+	.o_rsp_data(host_rsp_data),
+	.i_rsp_ready(1'b1),
+	.o_reg_addr(reg_rd_addr),
+	.i_reg_data(reg_rd_data),
+	.o_evt_rd_en(evt_rd_en),
+	.i_evt_data(evt_rd_data),
+	.i_edge_data(edge_rd_data),
+	.i_glyph_data(glyph_rd_data),
+	.i_ipal_data(ipal_rd_data),
+	.i_crc_data(crc_rd_data),
+	.o_fb_stb(fb_rd_stb),
+	.o_fb_col(fb_rd_col),
+	.o_fb_row(fb_rd_row),
+	.i_fb_grant(fb_rd_grant),
+	.i_fb_valid(fb_rd_valid & reg_fb_rd_taken),
+	.i_fb_data(fb_rd_data),
+	.o_cmd_valid(rb_cmd_valid),
+	.o_cmd_data(rb_cmd_data),
+	.i_cmd_ready(host_cmd_ready),
+	.i_disp_empty(rsp_fifo_empty),
+	.i_disp_data(rsp_fifo_data),
+	.o_disp_pop(rsp_fifo_pop)
 );
-*/
-/*
-canvas canvas_inst (
+
+cmd_processor cmd_processor_inst (
 	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_reg_we(reg_host_reg_we),
+	.i_reg_addr(reg_host_reg_addr),
+	.i_reg_data(reg_host_reg_data),
+	.i_rd_addr(reg_rd_addr),
+	.o_rd_data(reg_rd_data),
+	.o_ring_tail(ring_tail),
+	.o_call_overflow(call_overflow),
+	.o_last_fence(last_fence),
+	.o_fence_done(fence_done),
+	.o_frame_count(frame_count),
+	.o_scan_line(scan_line),
+	.i_scan_line(v_count_s),
+	.i_display_idle(reg_cmd_idle),
+	.i_host_valid(proc_host_valid),
+	.i_host_data(proc_host_data),
+	.o_host_ready(host_cmd_ready),
+	.o_mem_req(ring_mem_req),
+	.o_mem_addr(ring_mem_addr),
+	.i_mem_ack(arb_ack[1]),
+	.i_mem_data(arb_dout),
+	.o_cmd_valid(cmd_valid),
+	.o_cmd_data(cmd_data),
+	.i_cmd_full(cmd_fifo_full),
+	.i_cmd_empty(cmd_fifo_wr_empty)
+);
+
+// Text ring edge tracking, from the commands entering the command FIFO.
+//
+edge_fill #(
+	.EVENT_GAP(5)
+) edge_fill_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_cmd_valid(cmd_valid & ~cmd_fifo_full),
+	.i_cmd_data(cmd_data),
+	.i_rd_addr(reg_rd_addr[1:0]),
+	.o_rd_data(edge_rd_data),
+	.o_column_event(column_event),
+	.o_column_tag(column_tag),
+	.o_row_event(row_event),
+	.o_row_tag(row_tag)
+);
+
+glyph_cache glyph_cache_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_reg_we(reg_glyph_reg_we),
+	.i_reg_addr(reg_glyph_reg_addr),
+	.i_reg_data(reg_glyph_reg_data),
+	.i_rd_addr(reg_rd_addr[2:0]),
+	.o_rd_data(glyph_rd_data),
 	.i_pix_clk(pix_clk),
-	.i_blank(blank_s),
-    .i_cmd_clk(reg_cmd_clk),
-    .i_cmd_data(reg_cmd_data),
-	.i_scan_row({1'b0, v_count_s[8:1]}),
-	.i_scan_column({1'b0, h_count_s[9:1]}),
-	.o_color(new_color)
+	.i_miss_dropped(text_miss_valid & miss_fifo_full),
+	.i_miss_empty(miss_fifo_empty),
+	.i_miss_code(miss_fifo_data),
+	.o_miss_pop(miss_fifo_pop),
+	.o_mem_req(glyph_mem_req),
+	.o_mem_addr(glyph_mem_addr),
+	.i_mem_ack(arb_ack[3]),
+	.i_mem_data(arb_dout),
+	.o_glyph_we(glyph_we),
+	.o_glyph_addr(glyph_addr),
+	.o_glyph_data(glyph_data),
+	.o_tag_we(glyph_tag_we),
+	.o_tag_way(glyph_tag_way),
+	.o_tag_set(glyph_tag_set),
+	.o_tag_data(glyph_tag_data)
+);
+
+cmd_fifo #(
+	.WIDTH(16),
+	.ADDR_WIDTH(4)
+) miss_fifo_inst (
+	.i_rst(rst_s),
+	.i_wr_clk(pix_clk),
+	.i_wr_en(text_miss_valid),
+	.i_wr_data(text_miss_code),
+	.o_full(miss_fifo_full),
+	.o_wr_empty(),
+	.i_rd_clk(clk_100mhz),
+	.i_rd_en(miss_fifo_pop),
+	.o_rd_data(miss_fifo_data),
+	.o_empty(miss_fifo_empty)
+);
+
+// Completion events for the host. Source 0: FENCE completion. Source 1:
+// a text ring column went out of view. Source 2: a text ring row went out
+// of view. Source 3: a string was drawn. Source 4: a sprite blit is done.
+// host_irq will go to the host link, to wake the host when there are
+// events.
+//
+event_queue #(
+	.SOURCES(5),
+	.ADDR_WIDTH(4)
+) event_queue_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_event({sprite_done, str_done, row_event, column_event, fence_done}),
+	.i_event_tag({sprite_done_tag, str_done_tag, row_tag, column_tag, last_fence}),
+	.i_frame_count(frame_count),
+	.i_scan_line(scan_line),
+	.i_rd_addr(reg_rd_addr[1:0]),
+	.i_rd_en(evt_rd_en),
+	.o_rd_data(evt_rd_data),
+	.o_irq(host_irq)
+);
+
+viewport_streamer viewport_streamer_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_reg_we(reg_stream_reg_we),
+	.i_reg_addr(reg_stream_reg_addr),
+	.i_reg_data(reg_stream_reg_data),
+	.o_mem_req(stream_mem_req),
+	.o_mem_addr(stream_mem_addr),
+	.i_mem_ack(arb_ack[2]),
+	.i_mem_data(arb_dout),
+	.o_blit_stb(stream_blit_stb),
+	.o_blit_col(stream_blit_col),
+	.o_blit_row(stream_blit_row),
+	.o_blit_data(stream_blit_data),
+	.i_blit_grant(blit_grant & stream_blit_stb),
+	.o_cmd_valid(stream_cmd_valid),
+	.o_cmd_data(stream_cmd_data),
+	.i_cmd_ready(host_cmd_ready & ~rb_cmd_valid)
 );
-*/
-
-reg psram_stb;
-reg psram_we;
-reg [23:0] psram_addr;
-reg [15:0] psram_din;
-reg psram_busy;
-reg psram_done;
-reg [15:0] psram_dout;
-reg [5:0] psram_state;
-wire [7:0] psram_dinout;
-reg [2:0] test_state;
-reg finished;
-reg success;
 
+string_renderer string_renderer_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_reg_we(reg_str_reg_we),
+	.i_reg_addr(reg_str_reg_addr),
+	.i_reg_data(reg_str_reg_data),
+	.o_done(str_done),
+	.o_done_tag(str_done_tag),
+	.o_mem_req(str_mem_req),
+	.o_mem_addr(str_mem_addr),
+	.i_mem_ack(arb_ack[4]),
+	.i_mem_data(arb_dout),
+	.o_blit_stb(str_blit_stb),
+	.o_blit_col(str_blit_col),
+	.o_blit_row(str_blit_row),
+	.o_blit_data(str_blit_data),
+	.i_blit_grant(blit_grant & ~stream_blit_stb)
+);
+
+sprite_blit sprite_blit_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_reg_we(reg_sprite_reg_we),
+	.i_reg_addr(reg_sprite_reg_addr),
+	.i_reg_data(reg_sprite_reg_data),
+	.i_cmd_valid(cmd_valid & ~cmd_fifo_full),
+	.i_cmd_data(cmd_data),
+	.o_done(sprite_done),
+	.o_done_tag(sprite_done_tag),
+	.o_mem_req(sprite_mem_req),
+	.o_mem_addr(sprite_mem_addr),
+	.i_mem_ack(arb_ack[5]),
+	.i_mem_data(arb_dout),
+	.o_blit_stb(sprite_blit_stb),
+	.o_blit_we(sprite_blit_we),
+	.o_blit_col(sprite_blit_col),
+	.o_blit_row(sprite_blit_row),
+	.o_blit_data(sprite_blit_data),
+	.i_blit_grant(sprite_blit_grant),
+	.i_blit_data(fb_rd_data),
+	.o_lut_addr(lut_addr),
+	.i_lut_index(lut_index)
+);
+
+inverse_palette #(
+	.FULL_LIMIT(64)
+) inverse_palette_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_reg_we(reg_ipal_reg_we),
+	.i_reg_addr(reg_ipal_reg_addr),
+	.i_reg_data(reg_ipal_reg_data),
+	.i_rd_addr(reg_rd_addr[1:0]),
+	.o_rd_data(ipal_rd_data),
+	.i_cmd_valid(cmd_valid & ~cmd_fifo_full),
+	.i_cmd_data(cmd_data),
+	.i_lut_addr(lut_addr),
+	.o_lut_index(lut_index)
+);
+
+cmd_fifo #(
+	.WIDTH(32),
+	.ADDR_WIDTH(4)
+) cmd_fifo_inst (
+	.i_rst(rst_s),
+	.i_wr_clk(clk_100mhz),
+	.i_wr_en(cmd_valid),
+	.i_wr_data(cmd_data),
+	.o_full(cmd_fifo_full),
+	.o_wr_empty(cmd_fifo_wr_empty),
+	.i_rd_clk(pix_clk),
+	.i_rd_en(reg_cmd_pop),
+	.o_rd_data(cmd_fifo_data),
+	.o_empty(cmd_fifo_empty)
+);
+
+// Answers to READ display commands, captured in the pixel domain once
+// the command has ended (pump step 4), and carried back to the engine.
+// The readback module takes no more display reads than the FIFO holds,
+// so it is never full.
+//
+assign disp_rd_valid = canvas_rd_valid | text_rd_valid;
+assign disp_rd_data = canvas_rd_valid ? canvas_rd_data : text_rd_data;
+
+cmd_fifo #(
+	.WIDTH(32),
+	.ADDR_WIDTH(4)
+) rsp_fifo_inst (
+	.i_rst(rst_s),
+	.i_wr_clk(pix_clk),
+	.i_wr_en((reg_cmd_step == 3'd4) & disp_rd_valid),
+	.i_wr_data(disp_rd_data),
+	.o_full(),
+	.o_wr_empty(),
+	.i_rd_clk(clk_100mhz),
+	.i_rd_en(rsp_fifo_pop),
+	.o_rd_data(rsp_fifo_data),
+	.o_empty(rsp_fifo_empty)
+);
+
+// Pixel domain command pump. The display modules handle a command on one
+// rising edge of their command clock, and recover on the next, so each
+// command from the FIFO is given two command clock pulses. reg_cmd_idle is
+// high exactly while the pump is in step 0, from a single flop, so that it
+// can be carried to the engine domain (for FENCE) without glitches.
+//
 always @(posedge rst_s or posedge pix_clk) begin
 	if (rst_s) begin
-		psram_stb <= 0;
-		psram_we <= 0;
-		psram_addr <= 0;
-		psram_din <= 0;
-		test_state <= 0;
-		finished <= 0;
-		success <= 0;
+		reg_cmd_clk <= 0;
+		reg_cmd_data <= 0;
+		reg_cmd_step <= 0;
+		reg_cmd_idle <= 1;
+		reg_cmd_pop <= 0;
 	end else begin
-		case (test_state)
+		reg_cmd_pop <= 0;
+		case (reg_cmd_step)
 			3'd0: begin
-					// Wait for PSRAM startup
-					if (~psram_busy)
-						test_state <= 3'd1;
+					if (~cmd_fifo_empty & ~reg_cmd_pop) begin
+						reg_cmd_data <= cmd_fifo_data;
+						reg_cmd_pop <= 1;
+						reg_cmd_step <= 3'd1;
+						reg_cmd_idle <= 0;
+					end
 				end
 			3'd1: begin
-					// Write a 16-bit value
-					psram_we <= 1;
-					psram_stb <= 1;
-					test_state <= 3'd2;
+					reg_cmd_clk <= 1; // handle the command
+					reg_cmd_step <= 3'd2;
 				end
 			3'd2: begin
-					// Wait for the value to be written
-					if (psram_busy) begin
-						psram_stb <= 0;
-						psram_we <= 0;
-						test_state <= 3'd3;
-					end
+					reg_cmd_clk <= 0;
+					reg_cmd_step <= 3'd3;
 				end
 			3'd3: begin
-					// Read the value back again
-					if (~psram_busy) begin
-						psram_stb <= 1;
-						test_state <= 3'd4;
-					end
-				end
-			3'd4: begin
-					// Wait for the value to be read
-					if (psram_busy) begin
-						psram_stb <= 0;
-						test_state <= 3'd5;
-					end
+					reg_cmd_clk <= 1; // recover
+					reg_cmd_step <= 3'd4;
 				end
-			3'd5: begin
-					// Indicate completion
-					if (~psram_busy) begin
-						if (psram_din == psram_dout) begin
-							if (psram_addr == 24'hFFFFFF) begin
-								if (psram_din == 16'hFFFF) begin
-									finished <= 1;
-									success <= 1;
-									test_state <= 3'd6;
-								end else begin
-									psram_addr <= 0;
-									psram_din <= psram_din + 1;
-									test_state <= 3'd1;
-								end
-							end else begin
-								psram_addr <= psram_addr + 1;
-								test_state <= 3'd1;
-							end
-						end else begin
-							finished <= 1;
-							success <= 0;
-							test_state <= 3'd6;
-						end
-					end
+			default: begin
+					reg_cmd_clk <= 0;
+					reg_cmd_step <= 3'd0;
+					reg_cmd_idle <= 1;
 				end
-		endcase;
-	end;
+		endcase
+	end
 end
 
+// The display layers: the canvas is the background, and the text area is
+// blended over it. The canvas color trails its scan position by 1 clock.
+//
+text_area8x8 #(
+	.BG_LATENCY(1)
+) text_area8x8_inst (
+	.i_rst(rst_s),
+	.i_pix_clk(pix_clk),
+	.i_blank(blank_s),
+    .i_cmd_clk(reg_cmd_clk),
+    .i_cmd_data(reg_cmd_data),
+	.i_scan_row(v_count_s[8:0]),
+	.i_scan_column(h_count_s),
+	.i_bg_color(canvas_color),
+	.o_color(new_color),
+	.o_rd_valid(text_rd_valid),
+	.o_rd_data(text_rd_data),
+	.i_glyph_clk(clk_100mhz),
+	.i_glyph_we(glyph_we),
+	.i_glyph_addr(glyph_addr),
+	.i_glyph_data(glyph_data),
+	.i_tag_we(glyph_tag_we),
+	.i_tag_way(glyph_tag_way),
+	.i_tag_set(glyph_tag_set),
+	.i_tag_data(glyph_tag_data),
+	.o_miss_valid(text_miss_valid),
+	.o_miss_code(text_miss_code)
+);
+
+canvas canvas_inst (
+	.i_rst(rst_s),
+	.i_pix_clk(pix_clk),
+	.i_mem_clk(clk_100mhz),
+	.i_pix_phase(cnt_4_ph_0[1:0]),
+	.i_blank(blank_s),
+    .i_cmd_clk(reg_cmd_clk),
+    .i_cmd_data(reg_cmd_data),
+	.i_scan_row({1'b0, v_count_s[8:1]}),
+	.i_scan_column({1'b0, h_count_s[9:1]}),
+	.i_repeat_row(v_count_s[0]),
+	.i_repeat_column(h_count_s[0]),
+	.o_color(canvas_color),
+	.i_blit_stb(blit_stb),
+	.i_blit_we(blit_we),
+	.i_blit_col(blit_col),
+	.i_blit_row(blit_row),
+	.i_blit_data(blit_data),
+	.o_blit_grant(blit_grant),
+	.o_blit_valid(fb_rd_valid),
+	.o_blit_data(fb_rd_data),
+	.o_rd_valid(canvas_rd_valid),
+	.o_rd_data(canvas_rd_data)
+);
+
+frame_crc #(
+	.HEIGHT(480),
+	.LATENCY(DISPLAY_LATENCY)
+) frame_crc_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_reg_we(reg_crc_reg_we),
+	.i_reg_addr(reg_crc_reg_addr),
+	.i_reg_data(reg_crc_reg_data),
+	.i_rd_addr(reg_rd_addr[1:0]),
+	.o_rd_data(crc_rd_data),
+	.i_pix_clk(pix_clk),
+	.i_active(display_active),
+	.i_scan_row(v_count_s[8:0]),
+	.i_scan_column(h_count_s),
+	.i_color({o_r, o_g, o_b})
+);
+
+wire psram_stb;
+wire psram_we;
+wire [23:0] psram_addr;
+wire [15:0] psram_din;
+wire psram_busy;
+wire psram_done;
+wire [15:0] psram_dout;
+wire [5:0] psram_state;
+wire [5:0] arb_ack;
+wire [15:0] arb_dout;
+
+// Host PSRAM access, on port 0 of the arbiter. There is no host link yet,
+// so these are placeholders, and the port makes no requests.
+//
+reg reg_host_mem_req = 1'b0;
+reg reg_host_mem_we = 1'b0;
+reg [23:0] reg_host_mem_addr = 24'd0;
+reg [15:0] reg_host_mem_din = 16'd0;
+
+// Port 0: host PSRAM access.
+// Port 1: command ring fetches.
+// Port 2: viewport streaming reads.
+// Port 3: glyph cache loads.
+// Port 4: string glyph reads.
+// Port 5: sprite blit source reads.
+//
+psram_arbiter #(
+	.PORTS(6),
+	.PORT_BITS(3)
+) psram_arbiter_inst (
+	.i_rst(rst_s),
+	.i_clk(clk_100mhz),
+	.i_req({sprite_mem_req, str_mem_req, glyph_mem_req, stream_mem_req,
+	        ring_mem_req, reg_host_mem_req}),
+	.i_we({1'b0, 1'b0, 1'b0, 1'b0, 1'b0, reg_host_mem_we}),
+	.i_addr({sprite_mem_addr, str_mem_addr, glyph_mem_addr, stream_mem_addr,
+	         ring_mem_addr, reg_host_mem_addr}),
+	.i_din({16'd0, 16'd0, 16'd0, 16'd0, 16'd0, reg_host_mem_din}),
+	.o_ack(arb_ack),
+	.o_dout(arb_dout),
+	.o_stb(psram_stb),
+	.o_we(psram_we),
+	.o_addr(psram_addr),
+	.o_din(psram_din),
+	.i_busy(psram_busy),
+	.i_dout(psram_dout)
+);
+
 wire [34:0] states_hit;
 
 psram psram_inst (
 	.i_rst(rst_s),
-	.i_clk(pix_clk),
+	.i_clk(clk_100mhz),
 	.i_stb(psram_stb),
 	.i_we(psram_we),
 	.i_addr(psram_addr),
@@ -251,64 +789,13 @@ psram psram_inst (
 	.states_hit(states_hit)
 );
 
-wire is_color_bar;
-wire is_past_states;
-wire is_din_area;
-wire is_dout_area;
-wire is_state;
-wire is_din;
-wire is_dout;
-wire is_address;
-wire is_address_area;
-wire is_hit_area;
-wire is_hit;
-wire [11:0] color_bar_color;
-wire [11:0] din_color;
-wire [11:0] dout_color;
-wire [11:0] state_color;
-wire [11:0] side_color;
-wire [11:0] address_color;
-wire [11:0] hit_color;
-wire [5:0] graph_col;
-
-assign graph_col = h_count_s[9:4];
-assign is_address_area = (v_count_s < 16);
-assign is_color_bar = (v_count_s >= 16 && v_count_s < 32);
-assign is_hit_area = (v_count_s >= 32 && v_count_s < 64);
-assign is_din_area = (v_count_s >= 64 && v_count_s < 96);
-assign is_dout_area = (v_count_s >= 96 && v_count_s < 128);
-assign is_state = (graph_col == psram_state);
-assign is_hit = (graph_col < 34 && states_hit[graph_col]);
-assign is_past_states = (h_count_s >= 16*34);
-assign is_din = (graph_col < 16 && psram_din[15-graph_col]);
-assign is_dout = (graph_col < 16 && psram_dout[15-graph_col]);
-assign is_address = (graph_col < 24 && psram_addr[23-graph_col]);
-
-assign color_bar_color = ({h_count_s[8:5],h_count_s[7:4],h_count_s[8:5]});
-assign din_color = (is_din ? 12'hC00 : 12'h000);
-assign dout_color = (is_dout ? 12'h0C0 : 12'h000);
-assign state_color = (is_state ? 12'hCC0 : 12'h000);
-assign side_color = (finished ? (success ? 12'h040 : 12'h400) : 12'h222);
-assign address_color = (is_address ? 12'h0C8 : 12'h000);
-assign hit_color = (is_hit ? 12'hC3C : 12'h000);
-
-assign new_color =
-	h_count_s[3:0] == 0 ? 12'h222 :
-	is_address_area ? address_color :
-	is_color_bar ? color_bar_color :
-	is_hit_area ? hit_color :
-	is_past_states ? side_color :
-	is_din_area ? din_color :
-	is_dout_area ? dout_color :
-	state_color;
-
 assign rst_s = ~rstn_i;
 assign o_led = 8'b0;
 assign o_clk = clk_i;
 assign o_rst = rstn_i;
 assign blank_s = ~active_s;
-assign o_r = active_s ? new_color[11:8] : 4'd0;
-assign o_g = active_s ? new_color[7:4] : 4'd0;
-assign o_b = active_s ? new_color[3:0] : 4'd0;
+assign o_r = display_active ? new_color[11:8] : 4'd0;
+assign o_g = display_active ? new_color[7:4] : 4'd0;
+assign o_b = display_active ? new_color[3:0] : 4'd0;
 
 endmodule
@@ -0,0 +1,52 @@
+/*
+ * palette.v
+ *
+ * This module provides block RAM space for a color palette.
+ *
+ * Each entry is a 12-bit color (4 bits per color component). Both ports
+ * are registered (1 clock of read latency), so that the palette maps onto
+ * BRAM instead of flip-flops and a wide read multiplexer. Port A is meant
+ * for the command side (writes, and reads for readback), and port B for
+ * the pixel path.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module palette #(
+        parameter ADDR_WIDTH=8,
+        parameter INIT_FILE="../image/car336x256x256.pal"
+    )(
+        input wire wea,                         // write enable A
+        input wire web,                         // write enable B
+        input wire clka,                        // clock A
+        input wire clkb,                        // clock B
+        input wire [11:0] dia,                  // data in A
+        input wire [11:0] dib,                  // data in B
+        input wire [ADDR_WIDTH-1:0] addra,      // address A
+        input wire [ADDR_WIDTH-1:0] addrb,      // address B
+        output reg [11:0] doa,                  // data out A
+        output reg [11:0] dob                   // data out B
+    );
+
+    localparam DEPTH = (2**ADDR_WIDTH);
+    reg [11:0] colors [0:DEPTH-1];
+
+    initial $readmemh(INIT_FILE, colors);
+
+    always @(posedge clka) begin
+        if (wea) begin
+            colors[addra] <= dia;
+        end else
+            doa <= colors[addra];
+    end
+
+    always @(posedge clkb) begin
+        if (web) begin
+            colors[addrb] <= dib;
+        end else
+            dob <= colors[addrb];
+    end
+endmodule
@@ -0,0 +1,123 @@
+/*
+ * psram_arbiter.v
+ *
+ * This module shares the PSRAM controller (psram.v) between several
+ * requesters in the engine domain, such as the host PSRAM writes and the
+ * command processor.
+ *
+ * Each port holds i_req high, with i_we, i_addr, and i_din steady, until
+ * its o_ack bit goes high for one clock. For a read, o_dout holds the word
+ * read while o_ack is high (and until the next access completes). A port
+ * may keep i_req high across o_ack to ask for its next access, after
+ * changing the address (and data) on the o_ack clock.
+ *
+ * Ports are granted in round-robin order, one access at a time, starting
+ * after the port granted last, so no port can starve another.
+ *
+ * The port signals are packed, with port 0 in the low bits:
+ *
+ *  i_addr  = {..., port 1 address [23:0], port 0 address [23:0]}
+ *  i_din   = {..., port 1 data [15:0], port 0 data [15:0]}
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module psram_arbiter #(
+        parameter PORTS=2,
+        parameter PORT_BITS=1
+    )(
+        input  wire i_rst,
+        input  wire i_clk,
+        input  wire [PORTS-1:0] i_req,
+        input  wire [PORTS-1:0] i_we,
+        input  wire [PORTS*24-1:0] i_addr,
+        input  wire [PORTS*16-1:0] i_din,
+        output reg  [PORTS-1:0] o_ack,
+        output reg  [15:0] o_dout,
+        output reg  o_stb,
+        output reg  o_we,
+        output reg  [23:0] o_addr,
+        output reg  [15:0] o_din,
+        input  wire i_busy,
+        input  wire [15:0] i_dout
+    );
+
+    localparam ARB_IDLE = 2'd0;
+    localparam ARB_START = 2'd1;
+    localparam ARB_WAIT = 2'd2;
+
+    reg [1:0] reg_state;
+    reg [PORT_BITS-1:0] reg_port;
+    reg [PORT_BITS-1:0] reg_last;
+
+    // A port whose access just completed has not yet had a chance to
+    // change its request, so it is not considered on that clock.
+    wire [PORTS-1:0] requests = i_req & ~o_ack;
+
+    // The first requesting port after the one granted last.
+    reg [PORT_BITS-1:0] pick;
+    reg [PORT_BITS:0] index;
+    reg found;
+    integer i;
+
+    always @(*) begin
+        found = 0;
+        pick = 0;
+        for (i = 1; i <= PORTS; i = i + 1) begin
+            index = reg_last + i;
+            if (index >= PORTS)
+                index = index - PORTS;
+            if (~found & requests[index]) begin
+                found = 1;
+                pick = index[PORT_BITS-1:0];
+            end
+        end
+    end
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_state <= ARB_IDLE;
+            reg_port <= 0;
+            reg_last <= PORTS - 1;
+            o_ack <= 0;
+            o_dout <= 0;
+            o_stb <= 0;
+            o_we <= 0;
+            o_addr <= 0;
+            o_din <= 0;
+        end else begin
+            o_ack <= 0;
+            case (reg_state)
+                ARB_IDLE: begin
+                        // The controller is busy while it starts up.
+                        if (found & ~i_busy) begin
+                            reg_port <= pick;
+                            o_stb <= 1;
+                            o_we <= i_we[pick];
+                            o_addr <= i_addr[pick*24 +: 24];
+                            o_din <= i_din[pick*16 +: 16];
+                            reg_state <= ARB_START;
+                        end
+                    end
+                ARB_START: begin
+                        if (i_busy) begin
+                            o_stb <= 0;
+                            reg_state <= ARB_WAIT;
+                        end
+                    end
+                default: begin
+                        if (~i_busy) begin
+                            o_dout <= i_dout;
+                            o_ack[reg_port] <= 1;
+                            reg_last <= reg_port;
+                            reg_state <= ARB_IDLE;
+                        end
+                    end
+            endcase
+        end
+    end
+
+endmodule
@@ -0,0 +1,194 @@
+/*
+ * readback.v
+ *
+ * This module answers host reads, in the engine domain. The host gives a
+ * read request (space, address, and a tag of its choosing) on any clock
+ * that o_req_ready is high, without waiting for earlier reads to finish,
+ * and gets one response per request, carrying the same tag. Responses
+ * from different spaces may come back out of order; the tag tells them
+ * apart.
+ *
+ * Read spaces:
+ *
+ *  Space Contents                 Address              Data
+ *  ----- ------------------------ -------------------- ------------------
+ *   0    Engine registers and     register number      32 bits
+ *        counters (cmd_processor)
+ *   1    Completion events        0 to 2               32 bits
+ *        (event_queue.v)
+ *   2    Frame buffer bytes       {column[8:0],        palette index [7:0]
+ *                                  row[7:0]}
+ *   3    Canvas palette entries   index [7:0]          RGB [11:0]
+ *   4    Text cells               {column[6:0],        cell [23:0]
+ *                                  row[5:0]}
+ *   5    Text edge fill status    register number      32 bits
+ *        (edge_fill.v)
+ *   6    Glyph cache status       register number      32 bits
+ *        (glyph_cache.v)
+ *   7    Inverse palette status   register number      32 bits
+ *        (inverse_palette.v)
+ *   8    Frame signature          register number      32 bits
+ *        (frame_crc.v)
+ *
+ * Spaces 0, 1, 5, 6, 7 and 8 are answered on the clock after the request (reading
+ * address 1 of space 1 removes the oldest event), and space 2 a few
+ * clocks later, through the frame buffer blit port. Spaces 3 and 4 live in
+ * the pixel domain, so they are sent down the command stream as a READ
+ * display command, and the display modules' answers come back through a
+ * response FIFO (i_disp_*). Other spaces answer 0 at once.
+ *
+ * The response FIFO holds 2^RSP_ADDR_WIDTH answers, so no more display
+ * reads than that are taken until their answers have been given; the
+ * FIFO can then never drop one.
+ *
+ *  READ display command:
+ *
+ *  33222222222211111111110000000000
+ *  10987654321098765432109876543210
+ *  --------------------------------
+ *  1110SSSSTTTTTTTTAAAAAAAAAAAAAAAA    Read address A of space S, tag T
+ *
+ * A response is held on o_rsp_* until i_rsp_ready takes it.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module readback #(
+        parameter RSP_ADDR_WIDTH=4
+    )(
+    input  wire i_rst,
+    input  wire i_clk,
+    input  wire i_req_valid,
+    input  wire [3:0] i_req_space,
+    input  wire [19:0] i_req_addr,
+    input  wire [7:0] i_req_tag,
+    output wire o_req_ready,
+    output reg  o_rsp_valid,
+    output reg  [7:0] o_rsp_tag,
+    output reg  [31:0] o_rsp_data,
+    input  wire i_rsp_ready,
+    output wire [3:0] o_reg_addr,
+    input  wire [31:0] i_reg_data,
+    output wire o_evt_rd_en,
+    input  wire [31:0] i_evt_data,
+    input  wire [31:0] i_edge_data,
+    input  wire [31:0] i_glyph_data,
+    input  wire [31:0] i_ipal_data,
+    input  wire [31:0] i_crc_data,
+    output reg  o_fb_stb,
+    output reg  [8:0] o_fb_col,
+    output reg  [7:0] o_fb_row,
+    input  wire i_fb_grant,
+    input  wire i_fb_valid,
+    input  wire [7:0] i_fb_data,
+    output wire o_cmd_valid,
+    output wire [31:0] o_cmd_data,
+    input  wire i_cmd_ready,
+    input  wire i_disp_empty,
+    input  wire [31:0] i_disp_data,
+    output wire o_disp_pop
+);
+
+    localparam SPACE_REGS = 4'd0;
+    localparam SPACE_EVENTS = 4'd1;
+    localparam SPACE_FRAME = 4'd2;
+    localparam SPACE_PALETTE = 4'd3;
+    localparam SPACE_TEXT = 4'd4;
+    localparam SPACE_EDGE = 4'd5;
+    localparam SPACE_GLYPH = 4'd6;
+    localparam SPACE_IPAL = 4'd7;
+    localparam SPACE_CRC = 4'd8;
+
+    localparam OP_READ = 4'b1110;
+
+    // A frame buffer read in progress, and its answer, until it can be
+    // given as the response.
+    reg reg_fb_busy;
+    reg reg_fb_done;
+    reg [7:0] reg_fb_tag;
+    reg [7:0] reg_fb_data;
+
+    // Display reads taken whose answers have not yet been given.
+    reg [RSP_ADDR_WIDTH:0] reg_disp_owed;
+
+    wire disp_room = (reg_disp_owed != 2**RSP_ADDR_WIDTH);
+    wire rsp_free = ~o_rsp_valid | i_rsp_ready;
+    wire req_display = (i_req_space == SPACE_PALETTE) | (i_req_space == SPACE_TEXT);
+    wire req_frame = (i_req_space == SPACE_FRAME);
+    wire req_now = ~req_display & ~req_frame;
+
+    wire take_now = i_req_valid & req_now & rsp_free & ~reg_fb_done;
+    wire take_frame = i_req_valid & req_frame & ~reg_fb_busy;
+    wire take_display = i_req_valid & req_display & disp_room & i_cmd_ready;
+    wire give_frame = rsp_free & reg_fb_done;
+    wire give_display = rsp_free & ~take_now & ~reg_fb_done & ~i_disp_empty;
+
+    assign o_req_ready = req_display ? (disp_room & i_cmd_ready) :
+                         req_frame ? ~reg_fb_busy :
+                         (rsp_free & ~reg_fb_done);
+    assign o_reg_addr = i_req_addr[3:0];
+    assign o_evt_rd_en = take_now & (i_req_space == SPACE_EVENTS);
+    assign o_cmd_valid = i_req_valid & req_display & disp_room;
+    assign o_cmd_data = {OP_READ, i_req_space, i_req_tag, i_req_addr[15:0]};
+    assign o_disp_pop = give_display;
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            o_rsp_valid <= 0;
+            o_rsp_tag <= 0;
+            o_rsp_data <= 0;
+            o_fb_stb <= 0;
+            o_fb_col <= 0;
+            o_fb_row <= 0;
+            reg_fb_busy <= 0;
+            reg_fb_done <= 0;
+            reg_fb_tag <= 0;
+            reg_fb_data <= 0;
+            reg_disp_owed <= 0;
+        end else begin
+            if (i_rsp_ready)
+                o_rsp_valid <= 0;
+
+            if (take_now) begin
+                o_rsp_valid <= 1;
+                o_rsp_tag <= i_req_tag;
+                o_rsp_data <= (i_req_space == SPACE_REGS) ? i_reg_data :
+                              (i_req_space == SPACE_EVENTS) ? i_evt_data :
+                              (i_req_space == SPACE_EDGE) ? i_edge_data :
+                              (i_req_space == SPACE_GLYPH) ? i_glyph_data :
+                              (i_req_space == SPACE_IPAL) ? i_ipal_data :
+                              (i_req_space == SPACE_CRC) ? i_crc_data : 32'd0;
+            end else if (give_frame) begin
+                o_rsp_valid <= 1;
+                o_rsp_tag <= reg_fb_tag;
+                o_rsp_data <= {24'd0, reg_fb_data};
+                reg_fb_done <= 0;
+                reg_fb_busy <= 0;
+            end else if (give_display) begin
+                o_rsp_valid <= 1;
+                o_rsp_tag <= i_disp_data[31:24];
+                o_rsp_data <= {8'd0, i_disp_data[23:0]};
+            end
+
+            if (take_frame) begin
+                reg_fb_busy <= 1;
+                reg_fb_tag <= i_req_tag;
+                o_fb_stb <= 1;
+                o_fb_col <= i_req_addr[16:8];
+                o_fb_row <= i_req_addr[7:0];
+            end else if (o_fb_stb & i_fb_grant)
+                o_fb_stb <= 0;
+
+            if (i_fb_valid & reg_fb_busy & ~reg_fb_done) begin
+                reg_fb_data <= i_fb_data;
+                reg_fb_done <= 1;
+            end
+
+            reg_disp_owed <= reg_disp_owed + take_display - give_display;
+        end
+    end
+
+endmodule
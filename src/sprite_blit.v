@@ -0,0 +1,255 @@
+/*
+ * sprite_blit.v
+ *
+ * This module composites a rectangle of sprite-format pixels from PSRAM
+ * onto the canvas frame buffer, through the canvas blit port, in the
+ * engine domain, so anti-aliased decals can be baked into the background
+ * once, instead of being drawn every frame.
+ *
+ * Each source pixel is one PSRAM word, in the sprite data format (see
+ * memory_map.md): a 4-bit alpha code (bits 11:8) and a palette index
+ * (bits 7:0). The pixels are stored row by row, WIDTH words per row, from
+ * SOURCE. For each pixel:
+ *
+ *  - alpha 0: the frame buffer is left as it is.
+ *  - alpha 15: the palette index is written as it is.
+ *  - otherwise: the frame buffer byte under the pixel is read, both
+ *    indexes are resolved to colors through a copy of the canvas palette,
+ *    the colors are blended (color_blender.v, linear or gamma-correct),
+ *    and the blend is written back as the nearest palette index, from the
+ *    inverse palette (inverse_palette.v).
+ *
+ * The copy of the canvas palette is kept up to date by watching the
+ * canvas palette commands (00000100) as they enter the command FIFO, as
+ * the canvas will see them. Pixels past the right or bottom edge of the
+ * frame buffer are skipped. When the rectangle is done, o_done pulses for
+ * one clock, with the PSRAM address after its last pixel on o_done_tag.
+ *
+ * Host register writes (i_reg_we, i_reg_addr, i_reg_data):
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   SOURCE     23:0   PSRAM address of the top left source pixel
+ *   1   DEST       23:16  Frame buffer row of the top of the rectangle
+ *                  8:0    Frame buffer column of its left edge
+ *   2   CONTROL    0      GAMMA: 1 = blend on linear light
+ *   3   BLIT       23:16  Height, in rows
+ *                  8:0    Width, in columns; starts the blit
+ *
+ * Register writes are ignored while a blit is in progress.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module sprite_blit (
+    input  wire i_rst,
+    input  wire i_clk,
+    input  wire i_reg_we,
+    input  wire [1:0] i_reg_addr,
+    input  wire [31:0] i_reg_data,
+    input  wire i_cmd_valid,
+    input  wire [31:0] i_cmd_data,
+    output reg  o_done,
+    output wire [23:0] o_done_tag,
+    output reg  o_mem_req,
+    output reg  [23:0] o_mem_addr,
+    input  wire i_mem_ack,
+    input  wire [15:0] i_mem_data,
+    output wire o_blit_stb,
+    output wire o_blit_we,
+    output wire [8:0] o_blit_col,
+    output wire [7:0] o_blit_row,
+    output wire [7:0] o_blit_data,
+    input  wire i_blit_grant,
+    input  wire [7:0] i_blit_data,
+    output wire [11:0] o_lut_addr,
+    input  wire [7:0] i_lut_index
+);
+
+    localparam REG_SOURCE = 2'd0;
+    localparam REG_DEST = 2'd1;
+    localparam REG_CONTROL = 2'd2;
+    localparam REG_BLIT = 2'd3;
+
+    localparam COLUMNS = 336;
+    localparam ROWS = 256;
+
+    localparam S_IDLE = 3'd0;
+    localparam S_READ = 3'd1;
+    localparam S_FETCH = 3'd2;
+    localparam S_DEST = 3'd3;
+    localparam S_COLORS = 3'd4;
+    localparam S_BLEND = 3'd5;
+    localparam S_WRITE = 3'd6;
+    localparam S_NEXT = 3'd7;
+
+    reg [23:0] reg_source;
+    reg [8:0] reg_left;
+    reg [7:0] reg_top;
+    reg reg_gamma;
+    reg [8:0] reg_width;
+    reg [7:0] reg_height;
+
+    // The pixel being composited.
+    reg [2:0] reg_state;
+    reg [8:0] reg_x;
+    reg [7:0] reg_y;
+    reg [3:0] reg_alpha;
+    reg [7:0] reg_index;
+    reg [7:0] reg_under;
+    reg [1:0] reg_wait;
+
+    wire [9:0] col = {1'b0, reg_left} + reg_x;
+    wire [8:0] row = {1'b0, reg_top} + reg_y;
+    wire in_frame = (col < COLUMNS) & (row < ROWS);
+    wire last_x = (reg_x == reg_width - 1);
+    wire last_y = (reg_y == reg_height - 1);
+
+    // The copy of the canvas palette: port A takes the palette commands,
+    // and reads the source color when no command is being taken; port B
+    // reads the color under the pixel.
+    wire pal_we = i_cmd_valid & (i_cmd_data[31:24] == 8'b00000100);
+    wire [11:0] src_color;
+    wire [11:0] under_color;
+    wire [11:0] blend_color;
+
+    palette #(
+        .ADDR_WIDTH(8),
+        .INIT_FILE("../image/car336x256x256.pal")
+    ) palette_copy (
+        .wea(pal_we),
+        .web(1'b0),
+        .clka(i_clk),
+        .clkb(i_clk),
+        .dia(i_cmd_data[11:0]),
+        .dib(12'd0),
+        .addra(pal_we ? i_cmd_data[19:12] : reg_index),
+        .addrb(reg_under),
+        .doa(src_color),
+        .dob(under_color)
+    );
+
+    color_blender color_blender_inst (
+        .i_clk(i_clk),
+        .i_gamma(reg_gamma),
+        .i_bg_color(under_color),
+        .i_fg_color(src_color),
+        .i_fg_alpha(reg_alpha),
+        .o_color(blend_color)
+    );
+
+    assign o_lut_addr = blend_color;
+    assign o_done_tag = reg_source;
+    assign o_blit_stb = (reg_state == S_FETCH) | (reg_state == S_WRITE);
+    assign o_blit_we = (reg_state == S_WRITE);
+    assign o_blit_col = col[8:0];
+    assign o_blit_row = row[7:0];
+    assign o_blit_data = (reg_alpha == 4'hF) ? reg_index : i_lut_index;
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_source <= 0;
+            reg_left <= 0;
+            reg_top <= 0;
+            reg_gamma <= 0;
+            reg_width <= 0;
+            reg_height <= 0;
+            reg_state <= S_IDLE;
+            reg_x <= 0;
+            reg_y <= 0;
+            reg_alpha <= 0;
+            reg_index <= 0;
+            reg_under <= 0;
+            reg_wait <= 0;
+            o_done <= 0;
+            o_mem_req <= 0;
+            o_mem_addr <= 0;
+        end else begin
+            o_done <= 0;
+
+            case (reg_state)
+                S_IDLE: begin
+                        if (i_reg_we) begin
+                            case (i_reg_addr)
+                                REG_SOURCE: reg_source <= i_reg_data[23:0];
+                                REG_DEST: begin
+                                        reg_left <= i_reg_data[8:0];
+                                        reg_top <= i_reg_data[23:16];
+                                    end
+                                REG_CONTROL: reg_gamma <= i_reg_data[0];
+                                REG_BLIT: begin
+                                        reg_width <= i_reg_data[8:0];
+                                        reg_height <= i_reg_data[23:16];
+                                        reg_x <= 0;
+                                        reg_y <= 0;
+                                        if ((i_reg_data[8:0] != 0) & (i_reg_data[23:16] != 0))
+                                            reg_state <= S_READ;
+                                        else
+                                            o_done <= 1;
+                                    end
+                            endcase
+                        end
+                    end
+                S_READ: begin
+                        if (~o_mem_req) begin
+                            o_mem_req <= 1;
+                            o_mem_addr <= reg_source;
+                        end else if (i_mem_ack) begin
+                            o_mem_req <= 0;
+                            reg_source <= reg_source + 1;
+                            reg_alpha <= i_mem_data[11:8];
+                            reg_index <= i_mem_data[7:0];
+                            if ((i_mem_data[11:8] == 4'h0) | ~in_frame)
+                                reg_state <= S_NEXT;
+                            else if (i_mem_data[11:8] == 4'hF)
+                                reg_state <= S_WRITE;
+                            else
+                                reg_state <= S_FETCH;
+                        end
+                    end
+                S_FETCH: begin
+                        if (i_blit_grant)
+                            reg_state <= S_DEST;
+                    end
+                S_DEST: begin
+                        // The frame buffer byte read on the last clock.
+                        reg_under <= i_blit_data;
+                        reg_state <= S_COLORS;
+                    end
+                S_COLORS: begin
+                        // Both colors are read on this clock (port A keeps
+                        // the source color if a palette command takes it).
+                        reg_wait <= 0;
+                        reg_state <= S_BLEND;
+                    end
+                S_BLEND: begin
+                        // The blend takes 3 clocks, and the inverse palette 1.
+                        reg_wait <= reg_wait + 1;
+                        if (reg_wait == 3)
+                            reg_state <= S_WRITE;
+                    end
+                S_WRITE: begin
+                        if (i_blit_grant)
+                            reg_state <= S_NEXT;
+                    end
+                default: begin
+                        if (~last_x) begin
+                            reg_x <= reg_x + 1;
+                            reg_state <= S_READ;
+                        end else if (~last_y) begin
+                            reg_x <= 0;
+                            reg_y <= reg_y + 1;
+                            reg_state <= S_READ;
+                        end else begin
+                            o_done <= 1;
+                            reg_state <= S_IDLE;
+                        end
+                    end
+            endcase
+        end
+    end
+
+endmodule
@@ -0,0 +1,227 @@
+/*
+ * string_renderer.v
+ *
+ * This module draws strings of proportional glyphs into the canvas frame
+ * buffer, through the canvas blit port, in the engine domain, so labels
+ * can be placed at any pixel position without pre-rendered bitmaps.
+ *
+ * A string is a run of 16-bit code points in PSRAM. Glyphs come from the
+ * same glyph set in PSRAM as the glyph cache (see glyph_cache.v): 16 words
+ * per glyph, from GLYPH_BASE, two words per row, 4 pixels per word as 4-bit
+ * alpha codes, leftmost pixel in the low bits. Each code point also has a
+ * width (0 to 8 pixels) in the low 4 bits of its word in the width table,
+ * at WIDTH_BASE + C. Only the columns within the width are drawn, and the
+ * pen then moves right by the width.
+ *
+ * The frame buffer holds palette indexes, so the alpha codes are used as
+ * 3-bit levels (alpha[3:1]): a pixel of level 0 is not drawn, and a pixel
+ * of level L (1 to 7) is drawn as palette index RAMP + L. The host sets
+ * palette entries RAMP+1 to RAMP+7 to the text color, blended over the
+ * background by 1/7 to 7/7. Pixels past the right or bottom edge of the
+ * frame buffer are not drawn.
+ *
+ * When a string is done, o_done pulses for one clock, with the pen column
+ * after its last glyph on o_done_tag (to post a completion event, see
+ * event_queue.v), so the host can draw the next string after it.
+ *
+ * Host register writes (i_reg_we, i_reg_addr, i_reg_data):
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   GLYPH_BASE 23:0   PSRAM address of the glyph for code point 0
+ *   1   WIDTH_BASE 23:0   PSRAM address of the width of code point 0
+ *   2   STRING     23:0   PSRAM address of the first code point
+ *   3   PEN        23:16  Frame buffer row of the top of the glyphs
+ *                  8:0    Frame buffer column of the left of the glyphs
+ *   4   DRAW       23:16  RAMP: palette index below the alpha levels
+ *                  7:0    Number of code points; starts drawing
+ *
+ * Register writes are ignored while a string is being drawn. PEN and STRING
+ * move on as the string is drawn, so the next DRAW continues after it.
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module string_renderer (
+    input  wire i_rst,
+    input  wire i_clk,
+    input  wire i_reg_we,
+    input  wire [2:0] i_reg_addr,
+    input  wire [31:0] i_reg_data,
+    output reg  o_done,
+    output wire [23:0] o_done_tag,
+    output reg  o_mem_req,
+    output reg  [23:0] o_mem_addr,
+    input  wire i_mem_ack,
+    input  wire [15:0] i_mem_data,
+    output wire o_blit_stb,
+    output wire [8:0] o_blit_col,
+    output wire [7:0] o_blit_row,
+    output wire [7:0] o_blit_data,
+    input  wire i_blit_grant
+);
+
+    localparam REG_GLYPH_BASE = 3'd0;
+    localparam REG_WIDTH_BASE = 3'd1;
+    localparam REG_STRING = 3'd2;
+    localparam REG_PEN = 3'd3;
+    localparam REG_DRAW = 3'd4;
+
+    localparam COLUMNS = 336;
+    localparam ROWS = 256;
+
+    localparam S_IDLE = 3'd0;
+    localparam S_CODE = 3'd1;
+    localparam S_WIDTH = 3'd2;
+    localparam S_WORD = 3'd3;
+    localparam S_PIXEL = 3'd4;
+
+    reg [23:0] reg_glyph_base;
+    reg [23:0] reg_width_base;
+    reg [23:0] reg_string;
+    reg [8:0] reg_pen_x;
+    reg [7:0] reg_pen_y;
+    reg [7:0] reg_ramp;
+    reg [7:0] reg_count;
+
+    // The glyph being drawn, and the word of it (4 pixels of one row).
+    reg [2:0] reg_state;
+    reg [15:0] reg_code;
+    reg [3:0] reg_width;
+    reg [2:0] reg_row;
+    reg reg_half;
+    reg [1:0] reg_pixel;
+    reg [15:0] reg_word;
+
+    wire [3:0] column = {reg_half, reg_pixel};
+    wire [2:0] level = reg_word[{reg_pixel, 2'b11} -: 3];
+    wire [9:0] x = {1'b0, reg_pen_x} + column;
+    wire [8:0] y = {1'b0, reg_pen_y} + reg_row;
+    wire visible = (level != 0) & (x < COLUMNS) & (y < ROWS);
+
+    // The last pixel of the word, of the row, and of the glyph.
+    wire last_pixel = (reg_pixel == 3) | (column + 1 == reg_width);
+    wire last_word = reg_half | (reg_width <= 4);
+    wire last_row = (reg_row == 7);
+
+    assign o_done_tag = {15'd0, reg_pen_x};
+    assign o_blit_stb = (reg_state == S_PIXEL) & visible;
+    assign o_blit_col = x[8:0];
+    assign o_blit_row = y[7:0];
+    assign o_blit_data = reg_ramp + level;
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_glyph_base <= 0;
+            reg_width_base <= 0;
+            reg_string <= 0;
+            reg_pen_x <= 0;
+            reg_pen_y <= 0;
+            reg_ramp <= 0;
+            reg_count <= 0;
+            reg_state <= S_IDLE;
+            reg_code <= 0;
+            reg_width <= 0;
+            reg_row <= 0;
+            reg_half <= 0;
+            reg_pixel <= 0;
+            reg_word <= 0;
+            o_done <= 0;
+            o_mem_req <= 0;
+            o_mem_addr <= 0;
+        end else begin
+            o_done <= 0;
+
+            case (reg_state)
+                S_IDLE: begin
+                        if (i_reg_we) begin
+                            case (i_reg_addr)
+                                REG_GLYPH_BASE: reg_glyph_base <= i_reg_data[23:0];
+                                REG_WIDTH_BASE: reg_width_base <= i_reg_data[23:0];
+                                REG_STRING: reg_string <= i_reg_data[23:0];
+                                REG_PEN: begin
+                                        reg_pen_x <= i_reg_data[8:0];
+                                        reg_pen_y <= i_reg_data[23:16];
+                                    end
+                                REG_DRAW: begin
+                                        reg_ramp <= i_reg_data[23:16];
+                                        reg_count <= i_reg_data[7:0];
+                                        if (i_reg_data[7:0] != 0)
+                                            reg_state <= S_CODE;
+                                        else
+                                            o_done <= 1;
+                                    end
+                            endcase
+                        end
+                    end
+                S_CODE: begin
+                        if (~o_mem_req) begin
+                            o_mem_req <= 1;
+                            o_mem_addr <= reg_string;
+                        end else if (i_mem_ack) begin
+                            o_mem_req <= 0;
+                            reg_code <= i_mem_data;
+                            reg_string <= reg_string + 1;
+                            reg_count <= reg_count - 1;
+                            reg_state <= S_WIDTH;
+                        end
+                    end
+                S_WIDTH: begin
+                        if (~o_mem_req) begin
+                            o_mem_req <= 1;
+                            o_mem_addr <= reg_width_base + reg_code;
+                        end else if (i_mem_ack) begin
+                            o_mem_req <= 0;
+                            reg_width <= (i_mem_data[3:0] > 8) ? 4'd8 : i_mem_data[3:0];
+                            reg_row <= 0;
+                            reg_half <= 0;
+                            if (i_mem_data[3:0] == 0)
+                                reg_state <= (reg_count == 0) ? S_IDLE : S_CODE;
+                            else
+                                reg_state <= S_WORD;
+                            o_done <= (i_mem_data[3:0] == 0) & (reg_count == 0);
+                        end
+                    end
+                S_WORD: begin
+                        if (~o_mem_req) begin
+                            o_mem_req <= 1;
+                            o_mem_addr <= reg_glyph_base + {4'd0, reg_code, 4'd0} + {reg_row, reg_half};
+                        end else if (i_mem_ack) begin
+                            o_mem_req <= 0;
+                            reg_word <= i_mem_data;
+                            reg_pixel <= 0;
+                            reg_state <= S_PIXEL;
+                        end
+                    end
+                default: begin
+                        if (~o_blit_stb | i_blit_grant) begin
+                            reg_pixel <= reg_pixel + 1;
+                            if (last_pixel) begin
+                                if (~last_word)
+                                    reg_half <= 1;
+                                else begin
+                                    reg_half <= 0;
+                                    reg_row <= reg_row + 1;
+                                end
+                                if (~last_word | ~last_row)
+                                    reg_state <= S_WORD;
+                                else begin
+                                    // The glyph is done; move the pen past it.
+                                    reg_pen_x <= reg_pen_x + reg_width;
+                                    if (reg_count == 0) begin
+                                        o_done <= 1;
+                                        reg_state <= S_IDLE;
+                                    end else
+                                        reg_state <= S_CODE;
+                                end
+                            end
+                        end
+                    end
+            endcase
+        end
+    end
+
+endmodule
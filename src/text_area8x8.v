@@ -8,13 +8,47 @@
  * the text cell background color, and then that intermediate color is blended
  * over the given background color. 
  *
+ * The text area is shown through up to 4 text windows. Each window has a
+ * screen rectangle, its own scroll offsets into the shared text array, its
+ * own text area alpha, and its own palette bank (one of 4 sets of FG and BG
+ * palettes). Where windows overlap, the higher numbered window is shown;
+ * outside every enabled window, the background shows through, and the
+ * text array is not read. Window 0 covers the whole screen by default, and
+ * the original scroll and alpha commands act on it, so a single full
+ * screen text area works as before. A status bar and a scrolling log pane,
+ * for example, are two windows onto different parts of the text array, and
+ * scrolling one does not disturb the other.
+ *
+ * Each cell holds a 16-bit code point. The glyph table in char_gen8x8.v is
+ * a cache of 256 glyphs, 2-way set associative, kept filled from PSRAM by
+ * glyph_cache.v: the glyph for code point C is in slot {way, C[6:0]} when
+ * that slot's tag (written through i_tag_*) is {valid, C[15:7]}. A cell
+ * whose glyph is not cached is shown in its background color alone, and
+ * its code point is reported on o_miss_code, with a one clock pulse on
+ * o_miss_valid, whenever it differs from the last one reported.
+ *
+ * The pixel path is a pure pipeline: o_color is the color for the scan
+ * position given 9 pixel clocks before (the text array read, the glyph tag
+ * read, the glyph read, the character blender, and the text area blender).
+ * i_bg_color is taken as the background for the scan position given
+ * BG_LATENCY clocks before, and is delayed inside to meet the character
+ * color. The caller should delay the display enable and sync by 9 clocks
+ * to match o_color.
+ *
+ * A READ command for space 4 reads a text cell (see readback.v). The cell
+ * is on o_rd_data, with the command's tag, once the command ends
+ * (o_rd_valid goes high on the command clock that ends the command, and
+ * stays high until the next command starts).
+ *
  * Copyright (C) 2024 Curtis Whitley
  * License: APACHE
  */
 
 `default_nettype none
 
-module text_area8x8 (
+module text_area8x8 #(
+        parameter BG_LATENCY=0
+    )(
     input  wire i_rst,
     input  wire i_pix_clk,
     input  wire i_blank,
@@ -23,7 +57,19 @@ module text_area8x8 (
     input  wire [8:0] i_scan_row,
     input  wire [9:0] i_scan_column,
     input  wire [11:0] i_bg_color,
-    output wire [11:0] o_color
+    output wire [11:0] o_color,
+    output reg  o_rd_valid,
+    output wire [31:0] o_rd_data,
+    input  wire i_glyph_clk,
+    input  wire i_glyph_we,
+    input  wire [13:0] i_glyph_addr,
+    input  wire [3:0] i_glyph_data,
+    input  wire i_tag_we,
+    input  wire i_tag_way,
+    input  wire [6:0] i_tag_set,
+    input  wire [9:0] i_tag_data,
+    output reg  o_miss_valid,
+    output reg  [15:0] o_miss_code
 );
 
     // The color palettes each hold 16 colors at 12 bits each (4 bits per
@@ -31,20 +77,49 @@ module text_area8x8 (
     // The default palettes are both set to EGA colors, from this site:
     //   https://moddingwiki.shikadi.net/wiki/EGA_Palette
     //
-    reg [11:0] reg_fg_palette_color[0:15];
-    reg [11:0] reg_bg_palette_color[0:15];
+    // There are 4 banks of 16 colors in each palette; a window picks one.
+    //
+    reg [11:0] reg_fg_palette_color[0:63];
+    reg [11:0] reg_bg_palette_color[0:63];
+
+    // The text windows. A window shows screen pixels from (left, top) up
+    // to, but not including, (right, bottom). A pixel at screen position
+    // (x, y) in the window shows text array pixel (x + scroll x offset,
+    // y + scroll y offset), wrapping around at the array edges. The scroll
+    // offsets default to zero, which means that the upper-left screen pixel
+    // is the upper-left pixel in the text cell for text row 0 and text
+    // column 0.
+    //
+    // The window alpha determines how the window is blended onto the given
+    // background.
+    //
+    localparam WINDOWS = 4;
+    reg [WINDOWS-1:0] reg_win_enable;
+    reg [9:0] reg_win_left[0:WINDOWS-1];
+    reg [9:0] reg_win_right[0:WINDOWS-1];
+    reg [8:0] reg_win_top[0:WINDOWS-1];
+    reg [8:0] reg_win_bottom[0:WINDOWS-1];
+    reg [9:0] reg_win_scroll_x[0:WINDOWS-1];
+    reg [8:0] reg_win_scroll_y[0:WINDOWS-1];
+    reg [3:0] reg_win_alpha[0:WINDOWS-1];
+    reg [1:0] reg_win_bank[0:WINDOWS-1];
+    reg [1:0] win_index;
+    reg win_hit;
 
-    // The scroll offsets default to zero, which means that the upper-left
-    // visible pixel is the upper-left pixel in the text cell for text row 0
-    // and text column 0.
+    // The blend mode selects whether glyphs and the text area are blended
+    // on gamma-encoded colors (0), or on linear light (1). Gamma-correct
+    // blending avoids dark fringes around anti-aliased characters.
     //
-    reg [9:0] reg_scroll_x_offset;
-    reg [8:0] reg_scroll_y_offset;
+    reg reg_gamma_blend = 1'b0;
 
-    // The text area alpha determines how the entire text area is
-    // blended onto the given background.
+    // The text array read (1 clock), the glyph tag read (1 clock), the glyph
+    // read (1 clock), and the character blender (3 clocks) delay the
+    // character color by this many pixels after the scan position. The
+    // background is delayed to meet it, and the text area blender then adds
+    // 3 clocks.
     //
-    reg [2:0] reg_text_area_alpha = 3'b110; // 100%
+    localparam CHAR_LATENCY = 6;
+    localparam BG_DELAY = CHAR_LATENCY - BG_LATENCY;
 
     // The items in this array are arranged as if it were a 2D array:
     // With 8x8 pixel cells on a 640x480 screen, there is enough room
@@ -60,27 +135,30 @@ module text_area8x8 (
     //
     // The format of each cell is:
     //
+    // Code point, upper 8 bits: 8 bits
     // FG palette index: 4 bits
     // BG palette index: 4 bits
-    // Character code: 8 bits
+    // Code point, lower 8 bits: 8 bits
     //
 
     reg reg_cmd_in_progress;
     reg reg_wea;
     reg reg_web;
-    reg reg_clka;
     wire wire_clkb;
-    reg [15:0] reg_dia;
-    reg [15:0] reg_dib;
+    reg [23:0] reg_dia;
+    reg [23:0] reg_dib;
     reg [12:0] reg_addra;
     wire [12:0] wire_addrb;
-    reg [15:0] reg_doa;
-    reg [15:0] reg_dob;
+    reg [23:0] reg_doa;
+    reg [23:0] reg_dob;
 
-    text_array8x8 text_array8x8_inst (
+    text_array8x8 #(
+        .DATA_WIDTH(24)
+    ) text_array8x8_inst (
         .wea(reg_wea),
         .web(reg_web),
-        .clka(reg_clka),
+        .enb(win_hit),
+        .clka(i_cmd_clk),
         .clkb(wire_clkb),
         .dia(reg_dia),
         .dib(reg_dib),
@@ -92,12 +170,51 @@ module text_area8x8 (
 
     initial begin
         $readmemh("../font/default_palette.bits", reg_fg_palette_color, 0, 15);
+        $readmemh("../font/default_palette.bits", reg_fg_palette_color, 16, 31);
+        $readmemh("../font/default_palette.bits", reg_fg_palette_color, 32, 47);
+        $readmemh("../font/default_palette.bits", reg_fg_palette_color, 48, 63);
         $readmemh("../font/default_palette.bits", reg_bg_palette_color, 0, 15);
+        $readmemh("../font/default_palette.bits", reg_bg_palette_color, 16, 31);
+        $readmemh("../font/default_palette.bits", reg_bg_palette_color, 32, 47);
+        $readmemh("../font/default_palette.bits", reg_bg_palette_color, 48, 63);
     end
 
     reg [5:0] reg_cursor_row;
     reg [6:0] reg_cursor_column;
 
+    // The window shown at the scan position, and its bank and alpha,
+    // delayed to meet the cell value and the character color.
+    //
+    reg [3:0] reg_bank_pipe;
+    reg [1:0] reg_win_hit_pipe;
+    reg [23:0] reg_alpha_pipe;
+    reg [11:0] reg_bg_pipe[0:BG_DELAY-1];
+    integer w;
+    integer r;
+    integer d;
+
+    always @(*) begin
+        win_hit = 0;
+        win_index = 0;
+        for (w = 0; w < WINDOWS; w = w + 1) begin
+            if (reg_win_enable[w] &
+                (i_scan_column >= reg_win_left[w]) & (i_scan_column < reg_win_right[w]) &
+                (i_scan_row >= reg_win_top[w]) & (i_scan_row < reg_win_bottom[w])) begin
+                win_hit = 1;
+                win_index = w;
+            end
+        end
+    end
+
+    always @(posedge i_pix_clk) begin
+        reg_bank_pipe <= {reg_bank_pipe[1:0], reg_win_bank[win_index]};
+        reg_win_hit_pipe <= {reg_win_hit_pipe[0], win_hit};
+        reg_alpha_pipe <= {reg_alpha_pipe[19:0], win_hit ? reg_win_alpha[win_index] : 4'd0};
+        reg_bg_pipe[0] <= i_bg_color;
+        for (d = 1; d < BG_DELAY; d = d + 1)
+            reg_bg_pipe[d] <= reg_bg_pipe[d-1];
+    end
+
     wire [9:0] adjusted_scan_row;
     wire [10:0] adjusted_scan_column;
     wire [9:0] wrapped_scan_row;
@@ -107,33 +224,111 @@ module text_area8x8 (
     wire [6:0] text_cell_column;
     wire [2:0] cell_scan_row;
     wire [2:0] cell_scan_column;
-    wire [15:0] cell_value;
-    wire [3:0] cell_fg_color_index;
-    wire [3:0] cell_bg_color_index;
-    wire [7:0] cell_char_code;
+    wire [23:0] cell_value;
+    reg [2:0] reg_read_scan_row;
+    reg [2:0] reg_read_scan_column;
+    reg [2:0] reg_cell_scan_row;
+    reg [2:0] reg_cell_scan_column;
+    reg [3:0] reg_cell_fg_color_index;
+    reg [3:0] reg_cell_bg_color_index;
+    reg [15:0] reg_cell_code;
+    wire glyph_hit0;
+    wire glyph_hit1;
+    wire glyph_hit;
+    wire [7:0] glyph_slot;
     wire [11:0] char_fg_color;
     wire [11:0] char_bg_color;
+    reg [11:0] reg_char_fg_color;
+    reg [11:0] reg_char_bg_color;
     wire [11:0] intermediate_color;
 
-    assign adjusted_scan_row ={1'b0,i_scan_row} + {1'b0,reg_scroll_y_offset};
-    assign wrapped_scan_row = adjusted_scan_row >= 672 ?
-        adjusted_scan_row - 672 : adjusted_scan_row;
+    // The text array is a ring of 84x64 cells (672x512 pixels), so the
+    // scrolled position wraps around at its edges.
+    //
+    assign adjusted_scan_row ={1'b0,i_scan_row} + {1'b0,reg_win_scroll_y[win_index]};
+    assign wrapped_scan_row = adjusted_scan_row >= 512 ?
+        adjusted_scan_row - 512 : adjusted_scan_row;
 
-    assign adjusted_scan_column = {1'b0,i_scan_column} + {1'b0,reg_scroll_x_offset};
-    assign wrapped_scan_column = adjusted_scan_column >= 512 ?
-        adjusted_scan_column - 512 : adjusted_scan_column;
+    assign adjusted_scan_column = {1'b0,i_scan_column} + {1'b0,reg_win_scroll_x[win_index]};
+    assign wrapped_scan_column = adjusted_scan_column >= 672 ?
+        adjusted_scan_column - 672 : adjusted_scan_column;
 
     assign text_cell_row = wrapped_scan_row[8:3];
     assign text_cell_column = wrapped_scan_column[9:3];
     assign cell_scan_row = wrapped_scan_row[2:0];
     assign cell_scan_column = wrapped_scan_column[2:0];
 
+    // The glyph tags: one per glyph slot, {valid, code point [15:7]}, for
+    // the slots of way 0 and way 1 in each set. At power on, the cache holds
+    // the BRAM font, with code point C in slot C.
+    //
+    reg [9:0] glyph_tags0 [0:127];
+    reg [9:0] glyph_tags1 [0:127];
+    reg [9:0] reg_tag0;
+    reg [9:0] reg_tag1;
+    integer t;
+
+    initial begin
+        for (t = 0; t < 128; t = t + 1) begin
+            glyph_tags0[t] = {1'b1, 9'd0};
+            glyph_tags1[t] = {1'b1, 9'd1};
+        end
+    end
+
+    always @(posedge i_glyph_clk) begin
+        if (i_tag_we) begin
+            if (i_tag_way)
+                glyph_tags1[i_tag_set] <= i_tag_data;
+            else
+                glyph_tags0[i_tag_set] <= i_tag_data;
+        end
+    end
+
     assign cell_value = reg_dob;
-    assign cell_fg_color_index = cell_value[15:12];
-    assign cell_bg_color_index = cell_value[11:8];
-    assign cell_char_code = cell_value[7:0];
-    assign char_fg_color = reg_fg_palette_color[cell_fg_color_index];
-    assign char_bg_color = reg_bg_palette_color[cell_bg_color_index];
+
+    // The position in the cell is held while the cell is read, so that it
+    // stays with the cell. The cell's tags are then read while the rest of
+    // the cell is held for one clock, along with that position.
+    //
+    always @(posedge i_pix_clk) begin
+        reg_read_scan_row <= cell_scan_row;
+        reg_read_scan_column <= cell_scan_column;
+        reg_tag0 <= glyph_tags0[cell_value[6:0]];
+        reg_tag1 <= glyph_tags1[cell_value[6:0]];
+        reg_cell_code <= {cell_value[23:16], cell_value[7:0]};
+        reg_cell_fg_color_index <= cell_value[15:12];
+        reg_cell_bg_color_index <= cell_value[11:8];
+        reg_cell_scan_row <= reg_read_scan_row;
+        reg_cell_scan_column <= reg_read_scan_column;
+    end
+
+    assign glyph_hit0 = (reg_tag0 == {1'b1, reg_cell_code[15:7]});
+    assign glyph_hit1 = (reg_tag1 == {1'b1, reg_cell_code[15:7]});
+    assign glyph_hit = glyph_hit0 | glyph_hit1;
+    assign glyph_slot = {glyph_hit1, reg_cell_code[6:0]};
+    assign char_bg_color = reg_bg_palette_color[{reg_bank_pipe[3:2], reg_cell_bg_color_index}];
+    assign char_fg_color = glyph_hit ?
+        reg_fg_palette_color[{reg_bank_pipe[3:2], reg_cell_fg_color_index}] : char_bg_color;
+
+    // The cell colors are held while the glyph is read, to meet its alpha.
+    //
+    always @(posedge i_pix_clk) begin
+        reg_char_fg_color <= char_fg_color;
+        reg_char_bg_color <= char_bg_color;
+    end
+
+    always @(posedge i_rst or posedge i_pix_clk) begin
+        if (i_rst) begin
+            o_miss_valid <= 0;
+            o_miss_code <= 0;
+        end else begin
+            o_miss_valid <= 0;
+            if (reg_win_hit_pipe[1] & ~glyph_hit & (reg_cell_code != o_miss_code)) begin
+                o_miss_valid <= 1;
+                o_miss_code <= reg_cell_code;
+            end
+        end
+    end
 
     assign wire_addrb = {text_cell_column, text_cell_row};
     //assign reg_web = 0;
@@ -141,76 +336,117 @@ module text_area8x8 (
 
     char_blender8x8 char_blender_inst (
         .i_clk(i_pix_clk),
-        .i_char(cell_char_code),
-        .i_row(cell_scan_row),
-        .i_column(cell_scan_column),
-        .i_fg_color(char_fg_color),
-        .i_bg_color(char_bg_color),
-        .o_color(intermediate_color)
+        .i_gamma(reg_gamma_blend),
+        .i_char(glyph_slot),
+        .i_row(reg_cell_scan_row),
+        .i_column(reg_cell_scan_column),
+        .i_fg_color(reg_char_fg_color),
+        .i_bg_color(reg_char_bg_color),
+        .o_color(intermediate_color),
+        .i_glyph_clk(i_glyph_clk),
+        .i_glyph_we(i_glyph_we),
+        .i_glyph_addr(i_glyph_addr),
+        .i_glyph_data(i_glyph_data)
     );
 
     color_blender blender (
-        .i_bg_color(i_bg_color),
+        .i_clk(i_pix_clk),
+        .i_gamma(reg_gamma_blend),
+        .i_bg_color(reg_bg_pipe[BG_DELAY-1]),
         .i_fg_color(intermediate_color),
-        .i_fg_alpha(reg_text_area_alpha),
+        .i_fg_alpha(reg_alpha_pipe[23:20]),
         .o_color(o_color)
     );
 
 /*
     Text Area commands:
 
+    Opcode 0000 is for the canvas (see canvas.v), and is ignored here.
+
     33222222222211111111110000000000
     10987654321098765432109876543210
     --------------------------------
-    0001xxxxxxxxxxxxxxxxxxXXXXXXXXXX    Set horizontal scroll position (X offset)
-    0010xxxxxxxxxxxxxxxxxxxYYYYYYYYY    Set vertical scroll position (Y offset)
-    0011xxxYYYYYYYYYxxxxxxXXXXXXXXXX    Set horizontal and vertical scroll positions (X and Y offsets)
-    0100xxxxxxxxxxxxIIIIRRRRGGGGBBBB    Set foreground palette color for index (RGB)
-    0101xxxxxxxxxxxxIIIIRRRRGGGGBBBB    Set background palette color for index (RGB)
-    0110xxxxxxxxxxxxxxxxxxxxxxxxxAAA    Set text area alpha value
+    0001xxxxxxxxxxxxxxxxxxXXXXXXXXXX    Set horizontal scroll position (X offset) of window 0
+    0010xxxxxxxxxxxxxxxxxxxYYYYYYYYY    Set vertical scroll position (Y offset) of window 0
+    0011xxxYYYYYYYYYxxxxxxXXXXXXXXXX    Set horizontal and vertical scroll positions (X and Y offsets) of window 0
+    0100xxxxxxxxxxKKIIIIRRRRGGGGBBBB    Set foreground palette color for bank and index (RGB)
+    0101xxxxxxxxxxKKIIIIRRRRGGGGBBBB    Set background palette color for bank and index (RGB)
+    0110xxxxxxxxxxxxxxxxxxxxxxxxAAAA    Set text area alpha value of window 0
     0111xxxxxxxxxxxxxCCCCCCCxxRRRRRR    Set cursor position (row and column)
-    1000xxxxxxxxxxxxFFFFBBBBCCCCCCCC    Set cell attributes (FG index, BG index, Character code)
+    1000xxxxHHHHHHHHFFFFBBBBCCCCCCCC    Set cell attributes (FG index, BG index, code point {H, C})
     1001xxxxxxxxxxxxxxxxxxxxxxxxFFFF    Set cell foreground (FG index)
     1010xxxxxxxxxxxxxxxxxxxxxxxxBBBB    Set cell background (BG index)
     1011xxxxxxxxxxxxxxxxxxxxCCCCCCCC    Set cell character code
+    1100xxxxxxxxxxxxxxxxxxxxxxxxxxxG    Set blend mode (G: 0 = linear, 1 = gamma-correct)
+    1101WW00xxRRRRRRRRRRxxLLLLLLLLLL    Set window W left (L) and right (R) screen columns
+    1101WW01xxxBBBBBBBBBxxxTTTTTTTTT    Set window W top (T) and bottom (B) screen rows
+    1101WW10xxxYYYYYYYYYxxXXXXXXXXXX    Set window W scroll positions (X and Y offsets)
+    1101WW11xxxxxxxxxxxxxxxEKKxxAAAA    Set window W enable (E), palette bank (K), and alpha (A)
+    11100100TTTTTTTTxxxCCCCCCCRRRRRR    Read cell at column C and row R (tag T)
 */
 
+    // Port A of the text array is clocked by the command clock. A cell
+    // write or read is set up on the command clock that handles the
+    // command, and happens on the following command clock (the one that
+    // ends the command).
+    //
+    localparam READ_SPACE = 4'd4;
+    reg reg_rd_pending;
+    reg [7:0] reg_rd_tag;
+
+    assign o_rd_data = {reg_rd_tag, reg_doa};
+
+
     always @(posedge i_rst or posedge i_cmd_clk) begin
         if (i_rst) begin
-            reg_scroll_x_offset <= 0;
-            reg_scroll_y_offset <= 0;
+            for (r = 0; r < WINDOWS; r = r + 1) begin
+                reg_win_left[r] <= 0;
+                reg_win_right[r] <= 640;
+                reg_win_top[r] <= 0;
+                reg_win_bottom[r] <= 480;
+                reg_win_scroll_x[r] <= 0;
+                reg_win_scroll_y[r] <= 0;
+                reg_win_alpha[r] <= 4'b1111; // 100%
+                reg_win_bank[r] <= 0;
+            end
+            reg_win_enable <= 1; // window 0 only
             reg_cmd_in_progress <= 0;
             reg_wea <= 0;
             reg_web <= 0;
-            reg_clka <= 0;
             //wire_clkb <= 0;
             reg_dia <= 0;
             reg_dib <= 0;
             reg_addra <= 0;
             //reg_addrb <= 0;
+            reg_rd_pending <= 0;
+            reg_rd_tag <= 0;
+            o_rd_valid <= 0;
         end else if (reg_cmd_in_progress) begin
             reg_cmd_in_progress <= 0;
+            reg_wea <= 0;
+            o_rd_valid <= reg_rd_pending;
+            reg_rd_pending <= 0;
         end else begin
             reg_cmd_in_progress <= 1;
+            o_rd_valid <= 0;
             case (i_cmd_data[31:28])
-                4'b0001: reg_scroll_x_offset <= i_cmd_data[9:0];
-                4'b0010: reg_scroll_y_offset <= i_cmd_data[8:0];
+                4'b0001: reg_win_scroll_x[0] <= i_cmd_data[9:0];
+                4'b0010: reg_win_scroll_y[0] <= i_cmd_data[8:0];
                 4'b0011: begin
-                            reg_scroll_x_offset <= i_cmd_data[9:0];
-                            reg_scroll_y_offset <= i_cmd_data[24:16];
+                            reg_win_scroll_x[0] <= i_cmd_data[9:0];
+                            reg_win_scroll_y[0] <= i_cmd_data[24:16];
                          end
-                4'b0100: reg_fg_palette_color[i_cmd_data[15:12]] <= i_cmd_data[11:0];
-                4'b0101: reg_bg_palette_color[i_cmd_data[15:12]] <= i_cmd_data[11:0];
-                4'b0110: reg_text_area_alpha <= i_cmd_data[2:0];
+                4'b0100: reg_fg_palette_color[i_cmd_data[17:12]] <= i_cmd_data[11:0];
+                4'b0101: reg_bg_palette_color[i_cmd_data[17:12]] <= i_cmd_data[11:0];
+                4'b0110: reg_win_alpha[0] <= i_cmd_data[3:0];
                 4'b0111: begin
                             reg_cursor_row <= i_cmd_data[24:16];
                             reg_cursor_column <= i_cmd_data[9:0];
                          end
                 4'b1000: begin
                             reg_addra = {reg_cursor_column, reg_cursor_row};
-                            reg_dia <= i_cmd_data[15:0];
+                            reg_dia <= i_cmd_data[23:0];
                             reg_wea <= 1;
-                            reg_clka <= 1;
                          end
                 4'b1001: begin
                             reg_addra = {reg_cursor_column, reg_cursor_row};
@@ -224,6 +460,35 @@ module text_area8x8 (
                             reg_addra = {reg_cursor_column, reg_cursor_row};
                             //reg_cells[{reg_cursor_column, reg_cursor_row}][7:0] <= i_cmd_data[7:0];
                          end
+                4'b1100: reg_gamma_blend <= i_cmd_data[0];
+                4'b1101: begin
+                            case (i_cmd_data[25:24])
+                                2'b00: begin
+                                        reg_win_left[i_cmd_data[27:26]] <= i_cmd_data[9:0];
+                                        reg_win_right[i_cmd_data[27:26]] <= i_cmd_data[21:12];
+                                    end
+                                2'b01: begin
+                                        reg_win_top[i_cmd_data[27:26]] <= i_cmd_data[8:0];
+                                        reg_win_bottom[i_cmd_data[27:26]] <= i_cmd_data[20:12];
+                                    end
+                                2'b10: begin
+                                        reg_win_scroll_x[i_cmd_data[27:26]] <= i_cmd_data[9:0];
+                                        reg_win_scroll_y[i_cmd_data[27:26]] <= i_cmd_data[20:12];
+                                    end
+                                2'b11: begin
+                                        reg_win_enable[i_cmd_data[27:26]] <= i_cmd_data[8];
+                                        reg_win_bank[i_cmd_data[27:26]] <= i_cmd_data[7:6];
+                                        reg_win_alpha[i_cmd_data[27:26]] <= i_cmd_data[3:0];
+                                    end
+                            endcase
+                         end
+                4'b1110: begin
+                            if (i_cmd_data[27:24] == READ_SPACE) begin
+                                reg_addra = i_cmd_data[12:0];
+                                reg_rd_tag <= i_cmd_data[23:16];
+                                reg_rd_pending <= 1;
+                            end
+                         end
             endcase
         end
     end
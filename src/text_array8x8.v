@@ -2,7 +2,16 @@
  * text_array8x8.v
  *
  * This module provides block RAM space for the text array.
- * 
+ *
+ * The array holds 84x64 cells, stored column by column, so the
+ * address of a cell is {column, row} (column*64+row). Because there
+ * are exactly 64 rows, that mapping is dense: addresses run from 0 to
+ * 5375 with no gaps. The memory is declared with exactly DEPTH entries
+ * (rather than 2**ADDR_WIDTH = 8192), so that synthesis only uses the
+ * BRAM needed for 5376 cells. Both ports keep their 1-clock read latency.
+ * Port B only reads while enb is high, so the display can skip reads for
+ * pixels that no text window covers.
+ *
  * Copyright (C) 2024 Curtis Whitley
  * License: APACHE
  */
@@ -11,10 +20,12 @@
 
 module text_array8x8 #(
         parameter DATA_WIDTH=16,
-        parameter ADDR_WIDTH=13
+        parameter ADDR_WIDTH=13,
+        parameter DEPTH=84*64
     )(
         input wire wea,                         // write enable A
         input wire web,                         // write enable B
+        input wire enb,                         // read enable B
         input wire clka,                        // clock A
         input wire clkb,                        // clock B
         input wire [DATA_WIDTH-1:0] dia,        // data in A
@@ -26,8 +37,7 @@ module text_array8x8 #(
     );
 
     localparam WORD = (DATA_WIDTH-1);
-    localparam DEPTH = (2**ADDR_WIDTH-1);
-    reg [WORD:0] memory [0:DEPTH];
+    reg [WORD:0] memory [0:DEPTH-1];
 
     initial $readmemh("../font/sample_text8x8.bits", memory);
 
@@ -41,7 +51,7 @@ module text_array8x8 #(
     always @(posedge clkb) begin
         if (web) begin
             memory[addrb] <= dib;
-        end else
+        end else if (enb)
             dob <= memory[addrb];
     end
 endmodule
@@ -0,0 +1,330 @@
+/*
+ * viewport_streamer.v
+ *
+ * This module keeps the canvas frame buffer (a 336x256 ring of pixels in
+ * BRAM) filled from a large virtual canvas, or world, in PSRAM, so that a
+ * world much larger than the frame buffer can be scrolled with no host
+ * involvement beyond setting the viewport position.
+ *
+ * The world is 4096x4096 pixels at 8 bits (palette indexes), stored row
+ * by row, two pixels per 16-bit PSRAM word (the even pixel in the low
+ * byte), starting at WORLD_BASE:
+ *
+ *  address = WORLD_BASE + y * 2048 + x / 2
+ *
+ * The frame buffer holds a 336x256 window of the world, whose upper-left
+ * world pixel (lx, ly) sits at frame buffer position (rx, ry), wrapping
+ * around at the buffer edges. The window is kept about 8 pixels larger
+ * than the 320x240 viewport on every side. When the viewport moves, the
+ * streamer reads the newly exposed world columns (256 pixels each) or
+ * rows (336 pixels each) from PSRAM, writes them over the frame buffer
+ * column or row that has just gone out of the window (through the canvas
+ * blit port), and moves the window by one pixel. Once the window is in
+ * place, it sends the canvas a scroll command (canvas opcode 0000, so the
+ * text area and its edge tracking are not moved) that shows the viewport.
+ *
+ * If the viewport jumps by a whole window or more, or when streaming is
+ * enabled or WORLD_BASE is written, the whole window is reloaded, row by
+ * row. A reload asked for by a register write starts once the row or
+ * column being copied is done, from the first row.
+ *
+ * Host register writes (i_reg_we, i_reg_addr, i_reg_data):
+ *
+ *  Addr Name       Bits   Meaning
+ *  ---- ---------- ------ ----------------------------------------------
+ *   0   WORLD_BASE 23:0   PSRAM address of world pixels (0,0) and (1,0)
+ *   1   VIEW       27:16  Viewport top world row (0 to 3856)
+ *                  11:0   Viewport left world column (0 to 3776)
+ *   2   CONTROL    0      1 = stream the world into the frame buffer
+ *
+ * Copyright (C) 2024 Curtis Whitley
+ * License: APACHE
+ */
+
+`default_nettype none
+
+module viewport_streamer (
+    input  wire i_rst,
+    input  wire i_clk,
+    input  wire i_reg_we,
+    input  wire [1:0] i_reg_addr,
+    input  wire [31:0] i_reg_data,
+    output reg  o_mem_req,
+    output reg  [23:0] o_mem_addr,
+    input  wire i_mem_ack,
+    input  wire [15:0] i_mem_data,
+    output reg  o_blit_stb,
+    output reg  [8:0] o_blit_col,
+    output reg  [7:0] o_blit_row,
+    output reg  [7:0] o_blit_data,
+    input  wire i_blit_grant,
+    output wire o_cmd_valid,
+    output wire [31:0] o_cmd_data,
+    input  wire i_cmd_ready
+);
+
+    localparam REG_WORLD_BASE = 2'd0;
+    localparam REG_VIEW = 2'd1;
+    localparam REG_CONTROL = 2'd2;
+
+    localparam COLUMNS = 336;
+    localparam ROWS = 256;
+    localparam MARGIN = 8;
+    localparam MAX_LX = 4096 - COLUMNS;
+    localparam MAX_LY = 4096 - ROWS;
+
+    localparam JOB_RELOAD = 3'd0;
+    localparam JOB_RIGHT = 3'd1;
+    localparam JOB_LEFT = 3'd2;
+    localparam JOB_DOWN = 3'd3;
+    localparam JOB_UP = 3'd4;
+
+    localparam S_IDLE = 2'd0;
+    localparam S_READ = 2'd1;
+    localparam S_WRITE = 2'd2;
+
+    reg [23:0] reg_world_base;
+    reg [11:0] reg_view_x;
+    reg [11:0] reg_view_y;
+    reg reg_enable;
+
+    // The window in the frame buffer: its world origin, and where that
+    // origin sits in the ring.
+    reg [11:0] reg_lx;
+    reg [11:0] reg_ly;
+    reg [8:0] reg_rx;
+    reg [7:0] reg_ry;
+    reg reg_loaded;
+    reg [8:0] reg_reload_row;
+
+    // A reload asked for by a register write, started once the run of
+    // pixels in flight (if any) is done.
+    reg reg_restart;
+
+    // The run of pixels (one world row or column) being copied.
+    reg [1:0] reg_state;
+    reg [2:0] reg_job;
+    reg reg_job_is_row;
+    reg [11:0] reg_wx;
+    reg [11:0] reg_wy;
+    reg [8:0] reg_count;
+
+    // The last PSRAM word read, since a row copy uses both of its pixels.
+    reg reg_cache_valid;
+    reg [23:0] reg_cache_addr;
+    reg [15:0] reg_cache_data;
+
+    // The last scroll position sent to the canvas.
+    reg reg_scroll_sent;
+    reg [8:0] reg_sent_x;
+    reg [7:0] reg_sent_y;
+
+    // The window origin wanted for the viewport, kept inside the world.
+    wire [11:0] target_x = (reg_view_x < MARGIN) ? 12'd0 :
+                           (reg_view_x - MARGIN > MAX_LX) ? MAX_LX : (reg_view_x - MARGIN);
+    wire [11:0] target_y = (reg_view_y < MARGIN) ? 12'd0 :
+                           (reg_view_y - MARGIN > MAX_LY) ? MAX_LY : (reg_view_y - MARGIN);
+    wire far_x = (target_x > reg_lx) ? (target_x - reg_lx >= COLUMNS) : (reg_lx - target_x >= COLUMNS);
+    wire far_y = (target_y > reg_ly) ? (target_y - reg_ly >= ROWS) : (reg_ly - target_y >= ROWS);
+    wire in_place = (target_x == reg_lx) & (target_y == reg_ly);
+
+    wire [8:0] rx_next = (reg_rx == COLUMNS - 1) ? 9'd0 : reg_rx + 1;
+    wire [8:0] rx_prev = (reg_rx == 0) ? (COLUMNS - 1) : reg_rx - 1;
+    wire [8:0] col_next = (o_blit_col == COLUMNS - 1) ? 9'd0 : o_blit_col + 1;
+
+    // The canvas scroll position that shows the viewport.
+    wire [9:0] scroll_sum = {1'b0, reg_rx} + {1'b0, reg_view_x[8:0] - reg_lx[8:0]};
+    wire [8:0] scroll_x = (scroll_sum >= COLUMNS) ? (scroll_sum - COLUMNS) : scroll_sum[8:0];
+    wire [7:0] scroll_y = reg_ry + (reg_view_y[7:0] - reg_ly[7:0]);
+    wire scroll_stale = ~reg_scroll_sent | (scroll_x != reg_sent_x) | (scroll_y != reg_sent_y);
+
+    wire [23:0] word_addr = reg_world_base + {1'b0, reg_wy, 11'd0} + {13'd0, reg_wx[11:1]};
+    wire [15:0] word = reg_cache_data;
+
+    assign o_cmd_valid = reg_enable & reg_loaded & ~reg_restart & in_place &
+                         (reg_state == S_IDLE) & scroll_stale;
+    assign o_cmd_data = {4'b0000, 4'b0011, 3'd0, 1'b0, scroll_y, 2'd0, 1'b0, scroll_x};
+
+    always @(posedge i_rst or posedge i_clk) begin
+        if (i_rst) begin
+            reg_world_base <= 0;
+            reg_view_x <= 0;
+            reg_view_y <= 0;
+            reg_enable <= 0;
+            reg_lx <= 0;
+            reg_ly <= 0;
+            reg_rx <= 0;
+            reg_ry <= 0;
+            reg_loaded <= 0;
+            reg_reload_row <= 0;
+            reg_restart <= 0;
+            reg_state <= S_IDLE;
+            reg_job <= JOB_RELOAD;
+            reg_job_is_row <= 0;
+            reg_wx <= 0;
+            reg_wy <= 0;
+            reg_count <= 0;
+            reg_cache_valid <= 0;
+            reg_cache_addr <= 0;
+            reg_cache_data <= 0;
+            reg_scroll_sent <= 0;
+            reg_sent_x <= 0;
+            reg_sent_y <= 0;
+            o_mem_req <= 0;
+            o_mem_addr <= 0;
+            o_blit_stb <= 0;
+            o_blit_col <= 0;
+            o_blit_row <= 0;
+            o_blit_data <= 0;
+        end else begin
+            if (o_cmd_valid & i_cmd_ready) begin
+                reg_scroll_sent <= 1;
+                reg_sent_x <= scroll_x;
+                reg_sent_y <= scroll_y;
+            end
+
+            case (reg_state)
+                S_IDLE: begin
+                        if (~reg_enable | i_reg_we) begin
+                            // Nothing to do (or the registers are changing).
+                        end else if (reg_restart) begin
+                            // Reload from the next clock.
+                            reg_restart <= 0;
+                            reg_loaded <= 0;
+                            reg_reload_row <= 0;
+                        end else if (reg_loaded & (far_x | far_y)) begin
+                            // Too far to stream; reload from the next clock.
+                            reg_loaded <= 0;
+                            reg_reload_row <= 0;
+                        end else if (~reg_loaded) begin
+                            if (reg_reload_row == 0) begin
+                                reg_lx <= target_x;
+                                reg_ly <= target_y;
+                                reg_rx <= 0;
+                                reg_ry <= 0;
+                                reg_scroll_sent <= 0;
+                            end
+                            if (reg_reload_row == ROWS)
+                                reg_loaded <= 1;
+                            else begin
+                                reg_job <= JOB_RELOAD;
+                                reg_job_is_row <= 1;
+                                reg_wx <= (reg_reload_row == 0) ? target_x : reg_lx;
+                                reg_wy <= ((reg_reload_row == 0) ? target_y : reg_ly) + reg_reload_row;
+                                o_blit_col <= 0;
+                                o_blit_row <= reg_reload_row[7:0];
+                                reg_count <= COLUMNS;
+                                reg_state <= S_READ;
+                            end
+                        end else if (target_x > reg_lx) begin
+                            reg_job <= JOB_RIGHT;
+                            reg_job_is_row <= 0;
+                            reg_wx <= reg_lx + COLUMNS;
+                            reg_wy <= reg_ly;
+                            o_blit_col <= reg_rx;
+                            o_blit_row <= reg_ry;
+                            reg_count <= ROWS;
+                            reg_state <= S_READ;
+                        end else if (target_x < reg_lx) begin
+                            reg_job <= JOB_LEFT;
+                            reg_job_is_row <= 0;
+                            reg_wx <= reg_lx - 1;
+                            reg_wy <= reg_ly;
+                            o_blit_col <= rx_prev;
+                            o_blit_row <= reg_ry;
+                            reg_count <= ROWS;
+                            reg_state <= S_READ;
+                        end else if (target_y > reg_ly) begin
+                            reg_job <= JOB_DOWN;
+                            reg_job_is_row <= 1;
+                            reg_wx <= reg_lx;
+                            reg_wy <= reg_ly + ROWS;
+                            o_blit_col <= reg_rx;
+                            o_blit_row <= reg_ry;
+                            reg_count <= COLUMNS;
+                            reg_state <= S_READ;
+                        end else if (target_y < reg_ly) begin
+                            reg_job <= JOB_UP;
+                            reg_job_is_row <= 1;
+                            reg_wx <= reg_lx;
+                            reg_wy <= reg_ly - 1;
+                            o_blit_col <= reg_rx;
+                            o_blit_row <= reg_ry - 1;
+                            reg_count <= COLUMNS;
+                            reg_state <= S_READ;
+                        end
+                    end
+                S_READ: begin
+                        if (reg_cache_valid & (reg_cache_addr == word_addr)) begin
+                            o_blit_data <= reg_wx[0] ? word[15:8] : word[7:0];
+                            o_blit_stb <= 1;
+                            reg_state <= S_WRITE;
+                        end else if (~o_mem_req) begin
+                            o_mem_req <= 1;
+                            o_mem_addr <= word_addr;
+                        end else if (i_mem_ack) begin
+                            o_mem_req <= 0;
+                            reg_cache_valid <= 1;
+                            reg_cache_addr <= o_mem_addr;
+                            reg_cache_data <= i_mem_data;
+                        end
+                    end
+                default: begin
+                        if (i_blit_grant) begin
+                            o_blit_stb <= 0;
+                            if (reg_job_is_row) begin
+                                reg_wx <= reg_wx + 1;
+                                o_blit_col <= col_next;
+                            end else begin
+                                reg_wy <= reg_wy + 1;
+                                o_blit_row <= o_blit_row + 1;
+                            end
+                            reg_count <= reg_count - 1;
+                            if (reg_count == 1) begin
+                                reg_state <= S_IDLE;
+                                case (reg_job)
+                                    JOB_RELOAD: reg_reload_row <= reg_reload_row + 1;
+                                    JOB_RIGHT: begin
+                                            reg_lx <= reg_lx + 1;
+                                            reg_rx <= rx_next;
+                                        end
+                                    JOB_LEFT: begin
+                                            reg_lx <= reg_lx - 1;
+                                            reg_rx <= rx_prev;
+                                        end
+                                    JOB_DOWN: begin
+                                            reg_ly <= reg_ly + 1;
+                                            reg_ry <= reg_ry + 1;
+                                        end
+                                    default: begin
+                                            reg_ly <= reg_ly - 1;
+                                            reg_ry <= reg_ry - 1;
+                                        end
+                                endcase
+                            end else
+                                reg_state <= S_READ;
+                        end
+                    end
+            endcase
+
+            if (i_reg_we) begin
+                case (i_reg_addr)
+                    REG_WORLD_BASE: begin
+                            reg_world_base <= i_reg_data[23:0];
+                            reg_cache_valid <= 0;
+                            reg_restart <= 1;
+                        end
+                    REG_VIEW: begin
+                            reg_view_x <= i_reg_data[11:0];
+                            reg_view_y <= i_reg_data[27:16];
+                        end
+                    REG_CONTROL: begin
+                            reg_enable <= i_reg_data[0];
+                            reg_restart <= 1;
+                        end
+                endcase
+            end
+        end
+    end
+
+endmodule
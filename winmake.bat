@@ -10,8 +10,13 @@ set DISP_640x480_60Hz=1
 :: project name and sources
 set TOP=ogege
 set VLOG_SRC=src/ogege.v src/char_gen8x8.v src/vga_core.v src/component_blender.v src/color_blender.v
+set VLOG_SRC=%VLOG_SRC% src/gamma_blender.v
 set VLOG_SRC=%VLOG_SRC% src/char_gen8x8.v src/text_area8x8.v src/text_array8x8.v src/canvas.v
-set VLOG_SRC=%VLOG_SRC% src/frame_buffer.v src/psram.v
+set VLOG_SRC=%VLOG_SRC% src/frame_buffer.v src/palette.v src/psram.v src/cmd_fifo.v
+set VLOG_SRC=%VLOG_SRC% src/psram_arbiter.v src/cmd_processor.v src/readback.v
+set VLOG_SRC=%VLOG_SRC% src/event_queue.v src/viewport_streamer.v src/edge_fill.v
+set VLOG_SRC=%VLOG_SRC% src/glyph_cache.v src/string_renderer.v src/sprite_blit.v
+set VLOG_SRC=%VLOG_SRC% src/inverse_palette.v src/frame_crc.v
 set VLOG_SRC=%VLOG_SRC% src/char_blender8x8.v src/gatemate_100MHz_pll.v
 set VHDL_SRC=src/ogege.vhd
 set LOG=0